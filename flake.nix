@@ -33,7 +33,7 @@
         src = ./.;
 
         inherit (pkgs.hyprland) nativeBuildInputs;
-        buildInputs = [];
+        buildInputs = [pkgs.libpng];
 
         meta = with lib; {
           homepage = "https://github.com/CapsAdmin/hyprdecor";
@@ -49,7 +49,7 @@
         src = ./.;
 
         inherit (pkgs.hyprland) nativeBuildInputs;
-        buildInputs = [];
+        buildInputs = [pkgs.libpng];
         
         cmakeFlags = ["-DCMAKE_BUILD_TYPE=Debug"];
         dontStrip = true;
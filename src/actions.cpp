@@ -0,0 +1,89 @@
+#include "actions.hpp"
+
+#include <hyprland/src/desktop/state/FocusState.hpp>
+#include <hyprland/src/desktop/view/Window.hpp>
+#include <hyprland/src/managers/KeybindManager.hpp>
+#include <format>
+
+#include "plugin.hpp"
+
+constexpr std::string_view DISPATCH_PREFIX = "dispatch:";
+constexpr std::string_view ACTIVE_WINDOW = "activewindow";
+
+SButtonAction parseButtonAction(const std::string &str)
+{
+    SButtonAction action;
+
+    if (!str.starts_with(DISPATCH_PREFIX))
+    {
+        action.args = str;
+        return action;
+    }
+
+    action.type = SButtonAction::ACTION_DISPATCH;
+
+    std::string rest = str.substr(DISPATCH_PREFIX.size());
+    rest.erase(0, rest.find_first_not_of(' '));
+
+    const auto SPACE = rest.find(' ');
+    action.dispatcher = rest.substr(0, SPACE);
+    if (SPACE != std::string::npos)
+    {
+        action.args = rest.substr(SPACE + 1);
+        action.args.erase(0, action.args.find_first_not_of(' '));
+    }
+
+    // killactive only knows the focused window, closewindow can be told which one
+    if (action.dispatcher == "killactive")
+    {
+        action.dispatcher = "closewindow";
+        action.args = ACTIVE_WINDOW;
+    }
+
+    return action;
+}
+
+std::string windowSelector(PHLWINDOW window)
+{
+    return std::format("address:0x{:x}", (uintptr_t)window.get());
+}
+
+void runButtonAction(const SButtonAction &action, PHLWINDOW window)
+{
+    if (action.type == SButtonAction::ACTION_EXEC)
+    {
+        g_pKeybindManager->m_dispatchers["exec"](action.args);
+        return;
+    }
+
+    const auto DISPATCHER = g_pKeybindManager->m_dispatchers.find(action.dispatcher);
+    if (DISPATCHER == g_pKeybindManager->m_dispatchers.end())
+    {
+        DEBUG_LOG("unknown dispatcher {}", action.dispatcher);
+        return;
+    }
+
+    if (!window)
+    {
+        DISPATCHER->second(action.args);
+        return;
+    }
+
+    // arguments naming the active window get this one instead
+    if (action.args.contains(ACTIVE_WINDOW))
+    {
+        std::string args = action.args;
+        const auto SELECTOR = windowSelector(window);
+        for (size_t pos = args.find(ACTIVE_WINDOW); pos != std::string::npos; pos = args.find(ACTIVE_WINDOW, pos + SELECTOR.size()))
+            args.replace(pos, ACTIVE_WINDOW.size(), SELECTOR);
+
+        DISPATCHER->second(args);
+        return;
+    }
+
+    // everything else acts on the focused window, make sure that is ours
+    if (Desktop::focusState()->window() != window)
+        Desktop::focusState()->fullWindowFocus(window);
+
+    DISPATCHER->second(action.args);
+}
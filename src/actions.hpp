@@ -0,0 +1,30 @@
+#pragma once
+
+#define WLR_USE_UNSTABLE
+
+#include <hyprland/src/desktop/DesktopTypes.hpp>
+#include <cstdint>
+#include <string>
+
+// What a button or double click does. Plain strings are run through the shell,
+// "dispatch:<dispatcher> [args]" calls a hyprland dispatcher in process.
+struct SButtonAction
+{
+    enum eType : uint8_t
+    {
+        ACTION_EXEC = 0,
+        ACTION_DISPATCH,
+    };
+
+    eType type = ACTION_EXEC;
+    std::string dispatcher;
+    std::string args;
+};
+
+SButtonAction parseButtonAction(const std::string &str);
+
+// dispatchers run against window instead of whatever happens to be focused
+void runButtonAction(const SButtonAction &action, PHLWINDOW window);
+
+// dispatcher argument that targets window
+std::string windowSelector(PHLWINDOW window);
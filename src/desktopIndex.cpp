@@ -0,0 +1,408 @@
+#include "desktopIndex.hpp"
+
+#include <hyprland/src/Compositor.hpp>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <utility>
+
+#include "plugin.hpp"
+
+constexpr uint32_t INOTIFY_MASK = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF;
+// parents only need to report new dirs, IN_MASK_ADD keeps the full mask if one is also indexed
+constexpr uint32_t PARENT_INOTIFY_MASK = IN_CREATE | IN_MOVED_TO | IN_ONLYDIR | IN_MASK_ADD;
+
+static std::string toLower(std::string str)
+{
+    std::ranges::transform(str, str.begin(), [](unsigned char c)
+                           { return std::tolower(c); });
+    return str;
+}
+
+static std::string trim(const std::string &str)
+{
+    const auto BEGIN = str.find_first_not_of(" \t\r");
+    if (BEGIN == std::string::npos)
+        return "";
+
+    return str.substr(BEGIN, str.find_last_not_of(" \t\r") - BEGIN + 1);
+}
+
+std::vector<std::string> xdgDataDirs()
+{
+    std::vector<std::string> dirs;
+
+    // Use XDG_DATA_HOME (defaults to ~/.local/share)
+    const char *xdgDataHome = getenv("XDG_DATA_HOME");
+    const char *home = getenv("HOME");
+    if (xdgDataHome && xdgDataHome[0] != '\0')
+        dirs.push_back(xdgDataHome);
+    else if (home)
+        dirs.push_back(std::string(home) + "/.local/share");
+
+    // Use XDG_DATA_DIRS (defaults to /usr/local/share:/usr/share)
+    const char *xdgDirs = getenv("XDG_DATA_DIRS");
+    std::stringstream ss(xdgDirs ? xdgDirs : "/usr/local/share:/usr/share");
+    std::string dir;
+    while (std::getline(ss, dir, ':'))
+    {
+        if (!dir.empty())
+            dirs.push_back(dir);
+    }
+
+    return dirs;
+}
+
+static int onInotifyReadable(int fd, uint32_t mask, void *data)
+{
+    ((CDesktopFileIndex *)data)->onInotify();
+    return 0;
+}
+
+CDesktopFileIndex::CDesktopFileIndex()
+{
+    // the event source has to be added from the main thread, scans may happen elsewhere
+    m_iInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_iInotifyFd >= 0)
+        m_pInotifySource = wl_event_loop_add_fd(g_pCompositor->m_wlEventLoop, m_iInotifyFd, WL_EVENT_READABLE, onInotifyReadable, this);
+}
+
+CDesktopFileIndex::~CDesktopFileIndex()
+{
+    if (m_pInotifySource)
+        wl_event_source_remove(m_pInotifySource);
+    if (m_iInotifyFd >= 0)
+        close(m_iInotifyFd);
+}
+
+std::string CDesktopFileIndex::fileId(const std::string &prefix, const std::string &name)
+{
+    // nested files get their subdirs in the id, a/b.desktop is a-b
+    std::string id = prefix + name.substr(0, name.size() - std::string_view(".desktop").size());
+    std::ranges::replace(id, '/', '-');
+    return id;
+}
+
+bool CDesktopFileIndex::parse(const std::string &path, SEntry &entry)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+        return false;
+
+    std::string line;
+    bool inDesktopEntry = false;
+
+    while (std::getline(file, line))
+    {
+        // Check if we're in the [Desktop Entry] section
+        if (line == "[Desktop Entry]")
+            inDesktopEntry = true;
+        else if (!line.empty() && line[0] == '[')
+            inDesktopEntry = false;
+
+        if (!inDesktopEntry)
+            continue;
+
+        const auto EQ = line.find('=');
+        if (EQ == std::string::npos)
+            continue;
+
+        const auto KEY = trim(line.substr(0, EQ));
+        if (KEY == "Icon")
+            entry.icon = trim(line.substr(EQ + 1));
+        else if (KEY == "StartupWMClass")
+            entry.wmClass = trim(line.substr(EQ + 1));
+    }
+
+    return true;
+}
+
+void CDesktopFileIndex::scan(std::unique_lock<std::mutex> &lock)
+{
+    m_iScans++;
+    m_bScanning = true;
+
+    // lookups keep using the old entries until the new ones are in
+    for (auto &[wd, _] : m_index.watches)
+        inotify_rm_watch(m_iInotifyFd, wd);
+    for (const auto WD : m_index.parentWatches)
+        inotify_rm_watch(m_iInotifyFd, WD);
+    m_index.watches.clear();
+    m_index.parentWatches.clear();
+    m_index.missing.clear();
+
+    // inotify events and stats come from the main thread, they must not wait for the walk
+    lock.unlock();
+
+    SIndex index;
+
+    for (const auto &dir : xdgDataDirs())
+        index.dirs.push_back(dir + "/applications/");
+
+    // Also add Flatpak paths
+    if (const char *home = getenv("HOME"))
+        index.dirs.push_back(std::string(home) + "/.local/share/flatpak/exports/share/applications/");
+    index.dirs.push_back("/var/lib/flatpak/exports/share/applications/");
+
+    for (size_t i = 0; i < index.dirs.size(); ++i)
+        scanDir(index, i, "");
+
+    rebuildKeys(index);
+
+    lock.lock();
+
+    m_index = std::move(index);
+    m_bScanning = false;
+    m_bScanned = true;
+
+    // a rescan after lost events may well find something new
+    if (m_iScans > 1)
+        m_iChanges++;
+
+    // events for the new watches that came in during the walk
+    const auto PENDING = std::exchange(m_vPendingEvents, {});
+    if (handleEvents(PENDING.data(), PENDING.size()))
+    {
+        m_iRefreshes++;
+        m_iChanges++;
+        rebuildKeys(m_index);
+    }
+}
+
+void CDesktopFileIndex::scanDir(SIndex &index, size_t dir, const std::string &prefix)
+{
+    std::error_code ec;
+    std::filesystem::directory_iterator it(index.dirs[dir] + prefix, ec);
+    if (ec)
+    {
+        // ~/.local/share/applications and the flatpak exports only appear with the first install
+        if (prefix.empty())
+            watchMissing(index, dir);
+        return;
+    }
+
+    watch(index, dir, prefix);
+
+    for (const auto &file : it)
+    {
+        const auto NAME = file.path().filename().string();
+
+        if (file.is_directory(ec))
+            scanDir(index, dir, prefix + NAME + "/");
+        else if (NAME.ends_with(".desktop"))
+            refresh(index, dir, fileId(prefix, NAME), file.path().string());
+    }
+}
+
+void CDesktopFileIndex::watch(SIndex &index, size_t dir, const std::string &prefix)
+{
+    if (m_iInotifyFd < 0)
+        return;
+
+    const int WD = inotify_add_watch(m_iInotifyFd, (index.dirs[dir] + prefix).c_str(), INOTIFY_MASK);
+    if (WD >= 0)
+        index.watches[WD] = SWatch{dir, prefix};
+}
+
+void CDesktopFileIndex::watchMissing(SIndex &index, size_t dir)
+{
+    if (std::ranges::find(index.missing, dir) == index.missing.end())
+        index.missing.push_back(dir);
+
+    if (m_iInotifyFd < 0)
+        return;
+
+    std::error_code ec;
+    auto parent = std::filesystem::path(index.dirs[dir]).parent_path();
+    while (!parent.empty() && !std::filesystem::is_directory(parent, ec))
+        parent = parent.parent_path();
+
+    if (parent.empty())
+        return;
+
+    const int WD = inotify_add_watch(m_iInotifyFd, parent.c_str(), PARENT_INOTIFY_MASK);
+    if (WD >= 0 && std::ranges::find(index.parentWatches, WD) == index.parentWatches.end())
+        index.parentWatches.push_back(WD);
+}
+
+bool CDesktopFileIndex::checkMissing(SIndex &index)
+{
+    // dirs that are still missing put themselves back, watching a closer parent if one appeared
+    const auto MISSING = std::exchange(index.missing, {});
+    for (const auto DIR : MISSING)
+        scanDir(index, DIR, "");
+
+    if (index.missing.empty())
+    {
+        for (const auto WD : index.parentWatches)
+        {
+            if (!index.watches.contains(WD))
+                inotify_rm_watch(m_iInotifyFd, WD);
+        }
+        index.parentWatches.clear();
+    }
+
+    return index.missing.size() != MISSING.size();
+}
+
+void CDesktopFileIndex::refresh(SIndex &index, size_t dir, const std::string &id, const std::string &path)
+{
+    auto &entries = index.entries[id];
+    std::erase_if(entries, [dir](const SEntry &e)
+                  { return e.dir == dir; });
+
+    SEntry entry;
+    entry.dir = dir;
+    if (parse(path, entry))
+    {
+        entries.push_back(entry);
+        std::ranges::sort(entries, {}, &SEntry::dir);
+    }
+
+    if (entries.empty())
+        index.entries.erase(id);
+}
+
+void CDesktopFileIndex::rebuildKeys(SIndex &index)
+{
+    index.exact.clear();
+    index.folded.clear();
+
+    // file ids win over wm classes, exact matches over folded ones
+    for (const auto &[id, _] : index.entries)
+    {
+        index.exact.emplace(id, id);
+        index.folded.emplace(toLower(id), id);
+    }
+
+    for (const auto &[id, entries] : index.entries)
+    {
+        const auto &WMCLASS = entries.front().wmClass;
+        if (WMCLASS.empty())
+            continue;
+
+        index.exact.emplace(WMCLASS, id);
+        index.folded.emplace(toLower(WMCLASS), id);
+    }
+
+    // reverse dns ids, org.gnome.Nautilus for nautilus
+    for (const auto &[id, _] : index.entries)
+    {
+        const auto DOT = id.rfind('.');
+        if (DOT != std::string::npos && DOT + 1 < id.size())
+            index.folded.emplace(toLower(id.substr(DOT + 1)), id);
+    }
+}
+
+bool CDesktopFileIndex::handleEvents(const char *buf, size_t len)
+{
+    bool changed = false;
+
+    for (size_t off = 0; off < len;)
+    {
+        const auto *EV = (const inotify_event *)(buf + off);
+        off += sizeof(inotify_event) + EV->len;
+
+        if (EV->mask & IN_Q_OVERFLOW)
+        {
+            // lost track, start over on the next lookup
+            m_bScanned = false;
+            continue;
+        }
+
+        if (std::ranges::find(m_index.parentWatches, EV->wd) != m_index.parentWatches.end())
+        {
+            if (EV->mask & IN_IGNORED)
+            {
+                // the parent itself went away, fall back to one that still exists
+                std::erase(m_index.parentWatches, EV->wd);
+                changed |= checkMissing(m_index);
+            }
+            else if ((EV->mask & IN_ISDIR) && (EV->mask & (IN_CREATE | IN_MOVED_TO)))
+                changed |= checkMissing(m_index);
+        }
+
+        const auto WATCH = m_index.watches.find(EV->wd);
+        if (WATCH == m_index.watches.end())
+            continue;
+
+        if (EV->mask & (IN_DELETE_SELF | IN_IGNORED))
+        {
+            m_index.watches.erase(WATCH);
+            continue;
+        }
+
+        if (EV->len == 0)
+            continue;
+
+        const auto [DIR, PREFIX] = WATCH->second;
+        const std::string NAME = EV->name;
+
+        if ((EV->mask & IN_ISDIR) && (EV->mask & (IN_CREATE | IN_MOVED_TO)))
+            scanDir(m_index, DIR, PREFIX + NAME + "/");
+        else if (NAME.ends_with(".desktop"))
+            refresh(m_index, DIR, fileId(PREFIX, NAME), m_index.dirs[DIR] + PREFIX + NAME);
+        else
+            continue;
+
+        changed = true;
+    }
+
+    return changed;
+}
+
+void CDesktopFileIndex::onInotify()
+{
+    std::lock_guard lock(m_mutex);
+
+    alignas(inotify_event) char buf[4096];
+    bool changed = false;
+
+    while (true)
+    {
+        const auto LEN = read(m_iInotifyFd, buf, sizeof(buf));
+        if (LEN <= 0)
+            break;
+
+        // the new watches belong to an index that isn't swapped in yet, it replays these
+        if (m_bScanning)
+            m_vPendingEvents.insert(m_vPendingEvents.end(), buf, buf + LEN);
+        else
+            changed |= handleEvents(buf, LEN);
+    }
+
+    if (changed && m_bScanned)
+    {
+        m_iRefreshes++;
+        m_iChanges++;
+        rebuildKeys(m_index);
+    }
+}
+
+std::string CDesktopFileIndex::iconFor(const std::string &appId)
+{
+    if (appId.empty())
+        return "";
+
+    std::unique_lock lock(m_mutex);
+
+    if (!m_bScanned && !m_bScanning)
+        scan(lock);
+
+    m_iLookups++;
+
+    auto it = m_index.exact.find(appId);
+    if (it == m_index.exact.end())
+    {
+        it = m_index.folded.find(toLower(appId));
+        if (it == m_index.folded.end())
+            return "";
+    }
+
+    const auto ENTRY = m_index.entries.find(it->second);
+    return ENTRY != m_index.entries.end() ? ENTRY->second.front().icon : "";
+}
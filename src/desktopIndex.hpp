@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct wl_event_source;
+
+// $XDG_DATA_HOME followed by $XDG_DATA_DIRS, most important first
+std::vector<std::string> xdgDataDirs();
+
+// All .desktop entries of the XDG application dirs, scanned once on first use
+// and kept up to date through inotify. Maps app ids to their Icon= value.
+// Lookups and scans come from the icon loader thread, inotify is handled on
+// the main thread. Scans walk the dirs without holding the lock.
+class CDesktopFileIndex
+{
+public:
+    CDesktopFileIndex();
+    ~CDesktopFileIndex();
+
+    CDesktopFileIndex(const CDesktopFileIndex &) = delete;
+    CDesktopFileIndex &operator=(const CDesktopFileIndex &) = delete;
+
+    // Tries the desktop file id, then StartupWMClass, then both case-insensitively.
+    std::string iconFor(const std::string &appId);
+
+    std::atomic<size_t> m_iScans = 0;
+    std::atomic<size_t> m_iRefreshes = 0;
+    std::atomic<size_t> m_iLookups = 0;
+    // bumped whenever entries changed after the first scan, answers from before may be stale
+    std::atomic<uint64_t> m_iChanges = 0;
+
+    size_t size() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_index.entries.size();
+    }
+
+    // called from the event loop when a watched dir changed
+    void onInotify();
+
+private:
+    struct SEntry
+    {
+        // index into m_vDirs, lower wins when several dirs have the same id
+        size_t dir = 0;
+        std::string icon;
+        std::string wmClass;
+    };
+
+    struct SWatch
+    {
+        size_t dir = 0;
+        // path below the applications dir, ids of nested files are prefixed with it
+        std::string prefix;
+    };
+
+    struct SIndex
+    {
+        std::vector<std::string> dirs;
+        // by desktop file id, one entry per dir that has it, best first
+        std::unordered_map<std::string, std::vector<SEntry>> entries;
+        // file ids and wm classes as is
+        std::unordered_map<std::string, std::string> exact;
+        // lowercased, only used when there is no exact match
+        std::unordered_map<std::string, std::string> folded;
+        std::unordered_map<int, SWatch> watches;
+        // applications dirs that didn't exist on the last scan, and the parents watched for them
+        std::vector<size_t> missing;
+        std::vector<int> parentWatches;
+    };
+
+    // called with the lock held, drops it while walking the dirs
+    void scan(std::unique_lock<std::mutex> &lock);
+    void scanDir(SIndex &index, size_t dir, const std::string &prefix);
+    void watch(SIndex &index, size_t dir, const std::string &prefix);
+    // watches the nearest existing parent of an applications dir that doesn't exist yet
+    void watchMissing(SIndex &index, size_t dir);
+    // scans missing dirs that were created since, returns whether any was
+    bool checkMissing(SIndex &index);
+    // re-reads one file after it changed, path may be gone by now
+    void refresh(SIndex &index, size_t dir, const std::string &id, const std::string &path);
+    void rebuildKeys(SIndex &index);
+    // applies raw inotify events to the current index, returns whether entries changed
+    bool handleEvents(const char *buf, size_t len);
+
+    static bool parse(const std::string &path, SEntry &entry);
+    static std::string fileId(const std::string &prefix, const std::string &name);
+
+    mutable std::mutex m_mutex;
+
+    bool m_bScanned = false;
+    bool m_bScanning = false;
+    SIndex m_index;
+
+    int m_iInotifyFd = -1;
+    wl_event_source *m_pInotifySource = nullptr;
+    // events read while a scan was running, replayed once its index is swapped in
+    std::vector<char> m_vPendingEvents;
+};
@@ -0,0 +1,109 @@
+#include "dragEngine.hpp"
+
+#include <hyprland/src/Compositor.hpp>
+#include <hyprland/src/desktop/view/Window.hpp>
+#include <hyprland/src/managers/LayoutManager.hpp>
+#include <hyprland/src/debug/log/Logger.hpp>
+
+#include "actions.hpp"
+
+CDragEngine::CDragEngine(HANDLE handle)
+{
+    // operator[] would add an empty dispatcher to hyprland's own table for a missing name
+    const auto FIND = [this](const std::string &name, DISPATCHER &out)
+    {
+        const auto IT = g_pKeybindManager->m_dispatchers.find(name);
+        if (IT == g_pKeybindManager->m_dispatchers.end())
+        {
+            Log::logger->log(Log::ERR, "[HYPRDECOR] Dispatcher {} not found, dragging windows by their bar is disabled", name);
+            m_bEnabled = false;
+            return;
+        }
+        out = IT->second;
+    };
+
+    FIND("setfloating", m_setFloating);
+    FIND("settiled", m_setTiled);
+    FIND("resizewindowpixel", m_resizeWindowPixel);
+    FIND("pin", m_pin);
+    FIND("mouse", m_mouse);
+
+    m_pPreRenderCallback = HyprlandAPI::registerCallbackDynamic(
+        handle, "preRender", [this](void *self, SCallbackInfo &info, std::any param)
+        { onPreRender(); });
+}
+
+void CDragEngine::beginMouseDrag()
+{
+    if (!m_bEnabled)
+        return;
+
+    m_mouse("1movewindow");
+}
+
+void CDragEngine::beginTouchDrag(PHLWINDOW window)
+{
+    if (!m_bEnabled)
+        return;
+
+    const auto SELECTOR = windowSelector(window);
+
+    m_setFloating(SELECTOR);
+    m_resizeWindowPixel("exact 50% 50%," + SELECTOR);
+    // pin it so you can change workspaces while dragging a window
+    m_pin(SELECTOR);
+
+    m_pWindow = window;
+}
+
+void CDragEngine::touchMove(PHLWINDOW window, const Vector2D &pos)
+{
+    if (!m_bEnabled)
+        return;
+
+    m_iMoveEvents++;
+
+    m_pWindow = window;
+    m_vPendingPos = pos;
+
+    if (const auto PMONITOR = window->m_monitor.lock())
+        g_pCompositor->scheduleFrameForMonitor(PMONITOR);
+}
+
+void CDragEngine::endDrag(PHLWINDOW window, bool touch)
+{
+    applyPendingMove();
+    m_pWindow.reset();
+
+    if (!m_bEnabled)
+        return;
+
+    m_mouse("0movewindow");
+    if (touch)
+        m_setTiled(windowSelector(window));
+}
+
+void CDragEngine::onPreRender()
+{
+    applyPendingMove();
+}
+
+void CDragEngine::applyPendingMove()
+{
+    if (!m_vPendingPos)
+        return;
+
+    const auto POS = *m_vPendingPos;
+    m_vPendingPos.reset();
+
+    const auto PWINDOW = m_pWindow.lock();
+    if (!PWINDOW || !validMapped(PWINDOW))
+        return;
+
+    const auto DELTA = POS.floor() - PWINDOW->m_realPosition->goal();
+    if (DELTA == Vector2D{})
+        return;
+
+    g_pLayoutManager->getCurrentLayout()->moveActiveWindow(DELTA, PWINDOW);
+    m_iMovesApplied++;
+}
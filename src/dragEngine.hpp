@@ -0,0 +1,50 @@
+#pragma once
+
+#define WLR_USE_UNSTABLE
+
+#include <hyprland/src/plugins/PluginAPI.hpp>
+#include <hyprland/src/desktop/DesktopTypes.hpp>
+#include <hyprland/src/managers/KeybindManager.hpp>
+#include <functional>
+#include <optional>
+#include <string>
+
+// Moves windows dragged by their bar. Dispatchers are looked up once, touch
+// motion moves the window directly and at most once per frame.
+class CDragEngine
+{
+public:
+    CDragEngine(HANDLE handle);
+
+    // mouse drags are handed to hyprland's own move bind
+    void beginMouseDrag();
+
+    // floats the window and makes it follow the finger
+    void beginTouchDrag(PHLWINDOW window);
+    // pos is where the window's top left should end up, in layout coordinates
+    void touchMove(PHLWINDOW window, const Vector2D &pos);
+
+    void endDrag(PHLWINDOW window, bool touch);
+
+    size_t m_iMoveEvents = 0;
+    size_t m_iMovesApplied = 0;
+
+private:
+    using DISPATCHER = std::function<SDispatchResult(std::string)>;
+
+    void onPreRender();
+    void applyPendingMove();
+
+    DISPATCHER m_setFloating;
+    DISPATCHER m_setTiled;
+    DISPATCHER m_resizeWindowPixel;
+    DISPATCHER m_pin;
+    DISPATCHER m_mouse;
+    // false when one of the dispatchers above doesn't exist in this hyprland
+    bool m_bEnabled = true;
+
+    PHLWINDOWREF m_pWindow;
+    std::optional<Vector2D> m_vPendingPos;
+
+    SP<HOOK_CALLBACK_FN> m_pPreRenderCallback;
+};
@@ -12,7 +12,9 @@
 #include <hyprland/src/managers/animation/AnimationManager.hpp>
 #include <hyprland/src/protocols/LayerShell.hpp>
 #include <hyprland/src/render/OpenGL.hpp>
+#include <hyprland/src/managers/eventLoop/EventLoopManager.hpp>
 #include <pango/pangocairo.h>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -28,43 +30,95 @@ CHyprWindowDecorator::CHyprWindowDecorator(PHLWINDOW pWindow) : IHyprWindowDecor
     const auto PMONITOR = pWindow->m_monitor.lock();
     PMONITOR->m_scheduledRecalc = true;
 
-    m_pAppIconTex = makeShared<CTexture>();
-
-    // button events
-    m_pMouseButtonCallback = HyprlandAPI::registerCallbackDynamic(
-        gPlugin->m_pHandle, "mouseButton", [&](void *self, SCallbackInfo &info, std::any param)
-        { onMouseButton(info, std::any_cast<IPointer::SButtonEvent>(param)); });
-    m_pTouchDownCallback = HyprlandAPI::registerCallbackDynamic(
-        gPlugin->m_pHandle, "touchDown", [&](void *self, SCallbackInfo &info, std::any param)
-        { onTouchDown(info, std::any_cast<ITouch::SDownEvent>(param)); });
-    m_pTouchUpCallback = HyprlandAPI::registerCallbackDynamic( //
-        gPlugin->m_pHandle, "touchUp", [&](void *self, SCallbackInfo &info, std::any param)
-        { onTouchUp(info, std::any_cast<ITouch::SUpEvent>(param)); });
-
-    // move events
-    m_pTouchMoveCallback = HyprlandAPI::registerCallbackDynamic(
-        gPlugin->m_pHandle, "touchMove", [&](void *self, SCallbackInfo &info, std::any param)
-        { onTouchMove(info, std::any_cast<ITouch::SMotionEvent>(param)); });
-    m_pMouseMoveCallback = HyprlandAPI::registerCallbackDynamic( //
-        gPlugin->m_pHandle, "mouseMove", [&](void *self, SCallbackInfo &info, std::any param)
-        { onMouseMove(std::any_cast<Vector2D>(param)); });
-
-    m_pTextTex = makeShared<CTexture>();
     m_pButtonsTex = makeShared<CTexture>();
 
-    m_pAppIconTex = makeShared<CTexture>();
     m_pBarFinalTex = makeShared<CTexture>();
 
+    m_pBarColorTex = makeShared<CTexture>();
+
     g_pAnimationManager->createAnimation(gPlugin->bar_color, m_cRealBarColor, g_pConfigManager->getAnimationPropertyConfig("border"), pWindow, AVARDAMAGE_NONE);
     m_cRealBarColor->setUpdateCallback([&](auto)
                                        { damageEntire(); });
+
+    // fires once a coalesced title change is due
+    m_pTitleTimer = makeShared<CEventLoopTimer>(std::nullopt, [this](SP<CEventLoopTimer> self, void *data)
+                                                { damageEntire(); }, nullptr);
+    g_pEventLoopManager->addTimer(m_pTitleTimer);
+
+    // fires once an interactive resize settled, the next draw rasterizes at the final size
+    m_pResizeTimer = makeShared<CEventLoopTimer>(std::nullopt, [this](SP<CEventLoopTimer> self, void *data)
+                                                 { damageEntire(); }, nullptr);
+    g_pEventLoopManager->addTimer(m_pResizeTimer);
 }
 
 CHyprWindowDecorator::~CHyprWindowDecorator()
 {
-    // Callbacks are automatically cleaned up when the shared pointers are destroyed
     if (gPlugin)
+    {
         std::erase(gPlugin->m_vBars, this);
+        gPlugin->m_mBarsByWindow.erase(m_pWindow);
+        gPlugin->m_pInputRouter->remove(this);
+    }
+
+    if (m_pTitleTimer)
+        g_pEventLoopManager->removeTimer(m_pTitleTimer);
+    if (m_pResizeTimer)
+        g_pEventLoopManager->removeTimer(m_pResizeTimer);
+}
+
+std::chrono::milliseconds CHyprWindowDecorator::titleUpdateInterval()
+{
+    auto interval = std::chrono::milliseconds(m_bWindowHasFocus ? gPlugin->title_update_interval : gPlugin->title_update_interval_unfocused);
+
+    // back off further for windows that keep changing their title, a burst that ended two windows ago no longer counts
+    const bool QUIET = Time::steadyNow() - m_titleChurnStart > TITLE_CHURN_WINDOW * 2;
+    const int CHURN = QUIET ? 0 : std::max(m_iTitleChurn, m_iLastTitleChurn);
+    if (CHURN > TITLE_CHURN_THRESHOLD)
+        interval = std::max(interval, std::min(interval * (CHURN / TITLE_CHURN_THRESHOLD + 1), std::chrono::milliseconds(TITLE_UPDATE_INTERVAL_MAX)));
+
+    return interval;
+}
+
+bool CHyprWindowDecorator::shouldUpdateTitle(const std::string &title)
+{
+    const auto NOW = Time::steadyNow();
+
+    if (title != m_szPendingTitle)
+    {
+        m_szPendingTitle = title;
+        m_iTitleChanges++;
+
+        const auto SINCE = NOW - m_titleChurnStart;
+        if (SINCE > TITLE_CHURN_WINDOW * 2)
+        {
+            m_iLastTitleChurn = 0;
+            m_iTitleChurn = 0;
+            m_titleChurnStart = NOW;
+        }
+        else if (SINCE > TITLE_CHURN_WINDOW)
+        {
+            m_iLastTitleChurn = m_iTitleChurn;
+            m_iTitleChurn = 0;
+            m_titleChurnStart = NOW;
+        }
+        m_iTitleChurn++;
+
+        // a change that replaces one we were still holding back never gets rasterized
+        if (m_bTitleUpdatePending)
+            m_iSuppressedTitleRasters++;
+    }
+
+    const auto INTERVAL = titleUpdateInterval();
+    const auto ELAPSED = std::chrono::duration_cast<std::chrono::milliseconds>(NOW - m_lastTitleUpdate);
+
+    if (ELAPSED >= INTERVAL)
+        return true;
+
+    // keep showing the old title and come back once the interval is up, so the latest value always lands
+    m_bTitleUpdatePending = true;
+    m_pTitleTimer->updateTimeout(INTERVAL - ELAPSED);
+
+    return false;
 }
 
 SDecorationPositioningInfo CHyprWindowDecorator::getPositioningInfo()
@@ -112,37 +166,23 @@ bool CHyprWindowDecorator::inputIsValid()
     if (!gPlugin->enabled)
         return false;
 
-    if (!m_pWindow->m_workspace || !m_pWindow->m_workspace->isVisible() || !g_pInputManager->m_exclusiveLSes.empty() ||
+    // shared by every decoration handling this event
+    const auto &CTX = gPlugin->m_pInputRouter->context();
+
+    if (!m_pWindow->m_workspace || !m_pWindow->m_workspace->isVisible() || CTX.exclusiveLS ||
         (g_pSeatManager->m_seatGrab && !g_pSeatManager->m_seatGrab->accepts(m_pWindow->wlSurface()->resource())))
         return false;
 
-    const auto WINDOWATCURSOR = g_pCompositor->vectorToWindowUnified(g_pInputManager->getMouseCoordsInternal(), Desktop::View::RESERVED_EXTENTS | Desktop::View::INPUT_EXTENTS | Desktop::View::ALLOW_FLOATING);
-
-    auto focusState = Desktop::focusState();
-    auto window = focusState->window();
-    auto monitor = focusState->monitor();
-
-    if (WINDOWATCURSOR != m_pWindow && m_pWindow != window)
+    // focus is read live, an earlier handler of this same event may have just changed it
+    if (CTX.windowAtCursor != m_pWindow && m_pWindow != Desktop::focusState()->window())
         return false;
 
-    // check if input is on top or overlay shell layers
-    auto PMONITOR = monitor;
-    PHLLS foundSurface = nullptr;
-    Vector2D surfaceCoords;
-
-    // check top layer
-    g_pCompositor->vectorToLayerSurface(g_pInputManager->getMouseCoordsInternal(), &PMONITOR->m_layerSurfaceLayers[ZWLR_LAYER_SHELL_V1_LAYER_TOP], &surfaceCoords, &foundSurface);
-
-    if (foundSurface)
-        return false;
-    // check overlay layer
-    g_pCompositor->vectorToLayerSurface(g_pInputManager->getMouseCoordsInternal(), &PMONITOR->m_layerSurfaceLayers[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY], &surfaceCoords,
-                                        &foundSurface);
-
-    if (foundSurface)
-        return false;
+    return !CTX.onLayerSurface;
+}
 
-    return true;
+bool CHyprWindowDecorator::hasGrab()
+{
+    return m_bDragPending || m_bDraggingThis || m_bCancelledDown || m_iButtonPressedIdx != -1;
 }
 
 void CHyprWindowDecorator::onMouseButton(SCallbackInfo &info, IPointer::SButtonEvent e)
@@ -204,15 +244,13 @@ void CHyprWindowDecorator::onTouchMove(SCallbackInfo &info, ITouch::SMotionEvent
     PMONITOR = PMONITOR ? PMONITOR : Desktop::focusState()->monitor();
     const auto COORDS = Vector2D(PMONITOR->m_position.x + e.pos.x * PMONITOR->m_size.x, PMONITOR->m_position.y + e.pos.y * PMONITOR->m_size.y);
 
+    const auto PWINDOW = m_pWindow.lock();
+
     if (!m_bDraggingThis)
-    {
-        // Initial setup for dragging a window.
-        g_pKeybindManager->m_dispatchers["setfloating"]("activewindow");
-        g_pKeybindManager->m_dispatchers["resizewindowpixel"]("exact 50% 50%,activewindow");
-        // pin it so you can change workspaces while dragging a window
-        g_pKeybindManager->m_dispatchers["pin"]("activewindow");
-    }
-    g_pKeybindManager->m_dispatchers["movewindowpixel"](std::format("exact {} {},activewindow", (int)(COORDS.x - (assignedBoxGlobal().w / 2)), (int)COORDS.y));
+        gPlugin->m_pDragEngine->beginTouchDrag(PWINDOW);
+
+    // applied once per frame, however many motion events arrive in between
+    gPlugin->m_pDragEngine->touchMove(PWINDOW, {COORDS.x - assignedBoxGlobal().w / 2, COORDS.y});
     m_bDraggingThis = true;
 }
 
@@ -233,18 +271,11 @@ void CHyprWindowDecorator::handleDownEvent(SCallbackInfo &info, std::optional<IT
         COORDS = Vector2D(PMONITOR->m_position.x + e.pos.x * PMONITOR->m_size.x, PMONITOR->m_position.y + e.pos.y * PMONITOR->m_size.y) - assignedBoxGlobal().pos();
     }
 
-    const bool BUTTONSRIGHT = gPlugin->bar_buttons_alignment != "left";
-    const std::string ON_DOUBLE_CLICK = gPlugin->on_double_click;
-
     if (!isPointOnBar(COORDS))
     {
         // Click is outside bar bounds - cleanup if we were dragging
         if (m_bDraggingThis)
-        {
-            if (m_bTouchEv)
-                g_pKeybindManager->m_dispatchers["settiled"]("activewindow");
-            g_pKeybindManager->m_dispatchers["mouse"]("0movewindow");
-        }
+            gPlugin->m_pDragEngine->endDrag(PWINDOW, m_bTouchEv);
 
         m_bDraggingThis = false;
         m_bDragPending = false;
@@ -269,10 +300,10 @@ void CHyprWindowDecorator::handleDownEvent(SCallbackInfo &info, std::optional<IT
         return;
     }
 
-    if (!ON_DOUBLE_CLICK.empty() &&
+    if (!gPlugin->on_double_click.empty() &&
         std::chrono::duration_cast<std::chrono::milliseconds>(Time::steadyNow() - m_lastMouseDown).count() < 400 /* Arbitrary delay I found suitable */)
     {
-        g_pKeybindManager->m_dispatchers["exec"](ON_DOUBLE_CLICK);
+        runButtonAction(gPlugin->on_double_click_action, PWINDOW);
         m_bDragPending = false;
     }
     else
@@ -294,10 +325,8 @@ void CHyprWindowDecorator::handleUpEvent(SCallbackInfo &info)
 
     if (m_bDraggingThis)
     {
-        g_pKeybindManager->m_dispatchers["mouse"]("0movewindow");
+        gPlugin->m_pDragEngine->endDrag(m_pWindow.lock(), m_bTouchEv);
         m_bDraggingThis = false;
-        if (m_bTouchEv)
-            g_pKeybindManager->m_dispatchers["settiled"]("activewindow");
     }
 
     m_bDragPending = false;
@@ -308,7 +337,7 @@ void CHyprWindowDecorator::handleUpEvent(SCallbackInfo &info)
     {
         if (indexToButton(cursorRelativeToBar()) == m_iButtonPressedIdx)
         {
-            g_pKeybindManager->m_dispatchers["exec"](gPlugin->m_vButtons[m_iButtonPressedIdx].cmd);
+            runButtonAction(gPlugin->m_vButtons[m_iButtonPressedIdx].action, m_pWindow.lock());
         }
         m_iButtonPressedIdx = -1;
         damageEntire();
@@ -317,83 +346,30 @@ void CHyprWindowDecorator::handleUpEvent(SCallbackInfo &info)
 
 void CHyprWindowDecorator::handleMovement()
 {
-    g_pKeybindManager->m_dispatchers["mouse"]("1movewindow");
+    gPlugin->m_pDragEngine->beginMouseDrag();
     m_bDraggingThis = true;
     return;
 }
 
 int CHyprWindowDecorator::indexToButton(Vector2D COORDS)
 {
-    const bool BUTTONSRIGHT = gPlugin->bar_buttons_alignment != "left";
-    const bool VERTICAL = gPlugin->decoration_title_placement == "left" || gPlugin->decoration_title_placement == "right";
-    const auto DECOBOX = assignedBoxGlobal();
-    const auto &NPI = m_bWindowHasFocus ? gPlugin->activeNinepatch : gPlugin->inactiveNinepatch;
-    const auto P = gPlugin->decoration_padding;
-
-    CBox topBarBox;
-    if (gPlugin->decoration_title_placement == "top")
-    {
-        topBarBox = {(double)(gPlugin->decoration_offset_left + NPI.padding[0] + P), 0.0, (double)(DECOBOX.w - (gPlugin->decoration_offset_left + gPlugin->decoration_offset_right + NPI.padding[0] + NPI.padding[2] + 2 * P)), (double)(gPlugin->decoration_offset_top + NPI.padding[1] + P)};
-    }
-    else if (gPlugin->decoration_title_placement == "bottom")
-    {
-        topBarBox = {(double)(gPlugin->decoration_offset_left + NPI.padding[0] + P), (double)(DECOBOX.h - (gPlugin->decoration_offset_bottom + NPI.padding[3] + P)), (double)(DECOBOX.w - (gPlugin->decoration_offset_left + gPlugin->decoration_offset_right + NPI.padding[0] + NPI.padding[2] + 2 * P)), (double)(gPlugin->decoration_offset_bottom + NPI.padding[3] + P)};
-    }
-    else if (gPlugin->decoration_title_placement == "left")
-    {
-        topBarBox = {0.0, (double)(gPlugin->decoration_offset_top + NPI.padding[1] + P), (double)(gPlugin->decoration_offset_left + NPI.padding[0] + P), (double)(DECOBOX.h - (gPlugin->decoration_offset_top + gPlugin->decoration_offset_bottom + NPI.padding[1] + NPI.padding[3] + 2 * P))};
-    }
-    else
-    {
-        topBarBox = {(double)(DECOBOX.w - (gPlugin->decoration_offset_right + NPI.padding[2] + P)), (double)(gPlugin->decoration_offset_top + NPI.padding[1] + P), (double)(gPlugin->decoration_offset_right + NPI.padding[2] + P), (double)(DECOBOX.h - (gPlugin->decoration_offset_top + gPlugin->decoration_offset_bottom + NPI.padding[1] + NPI.padding[3] + 2 * P))};
-    }
-
-    if (!VECINRECT(COORDS, topBarBox.x, topBarBox.y, topBarBox.x + topBarBox.w, topBarBox.y + topBarBox.h))
-        return -1;
-
-    const auto relativeCOORDS = COORDS - topBarBox.pos();
-    const auto BARBUF = VERTICAL ? Vector2D(topBarBox.h, topBarBox.w) : Vector2D(topBarBox.w, topBarBox.h);
-
-    const float iconReserved = gPlugin->decoration_appicon_enabled ? (VERTICAL ? topBarBox.w : topBarBox.h) : 0;
-    float offset = gPlugin->decoration_padding + (BUTTONSRIGHT ? 0 : iconReserved);
-    int idx = 0;
-    for (auto &b : gPlugin->m_vButtons)
-    {
-        const float alongSize = VERTICAL ? b.size.y : b.size.x;
-        const float acrossSize = VERTICAL ? b.size.x : b.size.y;
-        Vector2D currentPos = Vector2D((double)(BUTTONSRIGHT ? BARBUF.x - gPlugin->bar_button_padding - alongSize - offset : offset), (double)(BARBUF.y - acrossSize) / 2.0).floor();
-
-        if (VERTICAL)
-        {
-            if (VECINRECT(relativeCOORDS, currentPos.y, currentPos.x, currentPos.y + b.size.x, currentPos.x + b.size.y + gPlugin->bar_button_padding))
-                return idx;
-        }
-        else
-        {
-            if (VECINRECT(relativeCOORDS, currentPos.x, currentPos.y, currentPos.x + b.size.x + gPlugin->bar_button_padding, currentPos.y + b.size.y))
-                return idx;
-        }
-
-        offset += gPlugin->bar_button_padding + alongSize;
-        idx++;
-    }
-
-    return -1;
+    return layout().buttonAt(COORDS);
 }
 
-void CHyprWindowDecorator::renderText(SP<CTexture> out, const std::string &text, const CHyprColor &color, const Vector2D &bufferSize, const float scale, const int fontSize)
+const SDecorationLayout &CHyprWindowDecorator::layout()
 {
-    const auto CAIROSURFACE = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, bufferSize.x, bufferSize.y);
-    const auto CAIRO = cairo_create(CAIROSURFACE);
+    const auto PWINDOW = m_pWindow.lock();
+    const auto PMONITOR = PWINDOW ? PWINDOW->m_monitor.lock() : nullptr;
 
-    // clear the pixmap
-    cairo_save(CAIRO);
-    cairo_set_operator(CAIRO, CAIRO_OPERATOR_CLEAR);
-    cairo_paint(CAIRO);
-    cairo_restore(CAIRO);
+    m_layout.update(m_bAssignedBox.size(), PMONITOR ? PMONITOR->m_scale : m_layout.scale, m_bWindowHasFocus);
+    return m_layout;
+}
 
+Vector2D CHyprWindowDecorator::renderText(SP<CTexture> out, const std::string &text, const CHyprColor &color, const Vector2D &bufferSize, const float scale, const int fontSize)
+{
     // draw title using Pango
-    PangoLayout *layout = pango_cairo_create_layout(CAIRO);
+    PangoContext *context = pango_font_map_create_context(pango_cairo_font_map_get_default());
+    PangoLayout *layout = pango_layout_new(context);
     pango_layout_set_text(layout, text.c_str(), -1);
 
     PangoFontDescription *fontDesc = pango_font_description_from_string("sans");
@@ -406,21 +382,32 @@ void CHyprWindowDecorator::renderText(SP<CTexture> out, const std::string &text,
     pango_layout_set_width(layout, maxWidth * PANGO_SCALE);
     pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_NONE);
 
-    cairo_set_source_rgba(CAIRO, color.r, color.g, color.b, color.a);
-
     PangoRectangle ink_rect, logical_rect;
-    pango_layout_get_extents(layout, &ink_rect, &logical_rect);
+    pango_layout_get_pixel_extents(layout, &ink_rect, &logical_rect);
 
-    const int layoutWidth = ink_rect.width;
-    const int layoutHeight = logical_rect.height;
+    const int xOffset = std::round(bufferSize.x / 2.0 - ink_rect.width / 2.0);
+    const int yOffset = std::round(bufferSize.y / 2.0 - logical_rect.height / 2.0);
 
-    const double xOffset = (bufferSize.x / 2.0 - layoutWidth / PANGO_SCALE / 2.0);
-    const double yOffset = (bufferSize.y / 2.0 - layoutHeight / PANGO_SCALE / 2.0);
+    // only allocate what the glyphs actually cover
+    const Vector2D TEXPOS = {(double)(xOffset + ink_rect.x), (double)(yOffset + ink_rect.y)};
+    const Vector2D TEXSIZE = {(double)std::max(1, ink_rect.width), (double)std::max(1, ink_rect.height)};
 
-    cairo_move_to(CAIRO, xOffset, yOffset);
+    const auto CAIROSURFACE = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, TEXSIZE.x, TEXSIZE.y);
+    const auto CAIRO = cairo_create(CAIROSURFACE);
+
+    // clear the pixmap
+    cairo_save(CAIRO);
+    cairo_set_operator(CAIRO, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(CAIRO);
+    cairo_restore(CAIRO);
+
+    cairo_set_source_rgba(CAIRO, color.r, color.g, color.b, color.a);
+
+    cairo_move_to(CAIRO, xOffset - TEXPOS.x, yOffset - TEXPOS.y);
     pango_cairo_show_layout(CAIRO, layout);
 
     g_object_unref(layout);
+    g_object_unref(context);
 
     cairo_surface_flush(CAIROSURFACE);
 
@@ -436,99 +423,124 @@ void CHyprWindowDecorator::renderText(SP<CTexture> out, const std::string &text,
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
 #endif
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, bufferSize.x, bufferSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, DATA);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TEXSIZE.x, TEXSIZE.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, DATA);
+
+    out->m_size = TEXSIZE;
 
     // delete cairo
     cairo_destroy(CAIRO);
     cairo_surface_destroy(CAIROSURFACE);
+
+    return TEXPOS;
 }
 
-void CHyprWindowDecorator::renderBarTitle(const Vector2D &bufferSize, const float scale)
+void CHyprWindowDecorator::renderBarTitle(const float scale)
 {
-    const bool BUTTONSRIGHT = gPlugin->bar_buttons_alignment != "left";
-    const bool VERTICAL = gPlugin->decoration_title_placement == "left" || gPlugin->decoration_title_placement == "right";
+    // shaped for the size being rasterized for, placed by placeTitle
+    const auto &LAYOUT = m_rasterLayout;
 
-    const auto PWINDOW = m_pWindow.lock();
+    const auto scaledSize = gPlugin->decoration_title_size * scale;
+
+    const CHyprColor COLOR = m_bForcedTitleColor.value_or(gPlugin->col_text);
+
+    const float availableWidth = LAYOUT.title.w * scale;
+    const float maxWidth = std::max(0.0f, availableWidth);
+    // bucket the width so windows of similar size end up with the same layout and texture
+    const int widthBucket = (int)(maxWidth / TITLE_WIDTH_BUCKET) * TITLE_WIDTH_BUCKET;
 
-    const auto BORDERSIZE = PWINDOW->getRealBorderSize();
+    // the layout is shaped once and owned by the cache
+    PangoLayout *layout = gPlugin->m_titleLayouts.get(m_szLastTitle, gPlugin->bar_text_font, scaledSize, widthBucket);
 
-    float buttonSizes = gPlugin->bar_button_padding;
-    for (auto &b : gPlugin->m_vButtons)
+    int layoutWidth, layoutHeight;
+    pango_layout_get_size(layout, &layoutWidth, &layoutHeight);
+
+    STitleTextureKey key;
+    key.text = m_szLastTitle;
+    key.font = gPlugin->bar_text_font;
+    key.size = (int)std::round(scaledSize * PANGO_SCALE);
+    key.scale = (int)std::round(scale * 1000);
+    key.color = COLOR.getAsHex();
+    // text that fits looks the same at any width
+    key.maxWidth = pango_layout_is_ellipsized(layout) ? widthBucket : 0;
+
+    m_pTitleTex = gPlugin->m_titleTextures.get(key);
+    if (!m_pTitleTex)
     {
-        buttonSizes += (VERTICAL ? b.size.y : b.size.x) + gPlugin->bar_button_padding;
+        m_pTitleTex = gPlugin->m_titleTextures.insert(key, rasterTitle(layout, COLOR));
+        m_bTexturesGrew = true;
     }
 
-    const auto scaledSize = gPlugin->decoration_title_size * scale;
-    const auto scaledBorderSize = BORDERSIZE * scale;
-    const auto scaledButtonsSize = buttonSizes * scale;
-    const auto scaledBarPadding = gPlugin->decoration_padding * scale;
+    m_vTitleLayoutSize = {(double)layoutWidth / PANGO_SCALE, (double)layoutHeight / PANGO_SCALE};
+    placeTitle(scale);
+}
 
-    const CHyprColor COLOR = m_bForcedTitleColor.value_or(gPlugin->col_text);
+void CHyprWindowDecorator::placeTitle(const float scale)
+{
+    const auto &LAYOUT = m_layout;
+    // quarter turns applied when drawing, the texture itself is always horizontal
+    const int ROTATION = LAYOUT.rotation;
 
-    const auto CAIROSURFACE = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, bufferSize.x, bufferSize.y);
-    const auto CAIRO = cairo_create(CAIROSURFACE);
+    const auto BAR = barAxes(LAYOUT.barPx.size(), LAYOUT.vertical);
+    const float logicalWidth = BAR.x;
+    const float logicalHeight = BAR.y;
+    const float availableWidth = LAYOUT.title.w * scale;
 
-    // clear the pixmap
-    cairo_save(CAIRO);
-    cairo_set_operator(CAIRO, CAIRO_OPERATOR_CLEAR);
-    cairo_paint(CAIRO);
-    cairo_restore(CAIRO);
+    // Use float alignment (0.0 to 1.0)
+    const float align = std::clamp(gPlugin->decoration_title_align, 0.0f, 1.0f);
 
-    if (VERTICAL)
-    {
-        cairo_translate(CAIRO, bufferSize.x / 2.0, bufferSize.y / 2.0);
-        if (gPlugin->decoration_title_placement == "left")
-            cairo_rotate(CAIRO, -M_PI / 2.0);
-        else
-            cairo_rotate(CAIRO, M_PI / 2.0);
-        cairo_translate(CAIRO, -bufferSize.y / 2.0, -bufferSize.x / 2.0);
-    }
+    const int xOffset = std::round(LAYOUT.title.x * scale + (availableWidth - m_vTitleLayoutSize.x) * align);
+    const int yOffset = std::round((logicalHeight / 2.0 - m_vTitleLayoutSize.y / 2.0));
 
-    const float logicalWidth = VERTICAL ? bufferSize.y : bufferSize.x;
-    const float logicalHeight = VERTICAL ? bufferSize.x : bufferSize.y;
+    // where the ink of the text sits along the bar...
+    const CBox INKBOX = m_pTitleTex->inkBox.copy().translate({(double)xOffset, (double)yOffset});
 
-    // draw title using Pango
-    PangoLayout *layout = pango_cairo_create_layout(CAIRO);
-    pango_layout_set_text(layout, m_szLastTitle.c_str(), -1);
+    // ...and the rect it covers in the bar buffer once rotated
+    CBox texBox = INKBOX;
+    if (ROTATION < 0)
+        texBox = {INKBOX.y, logicalWidth - INKBOX.x - INKBOX.w, INKBOX.h, INKBOX.w};
+    else if (ROTATION > 0)
+        texBox = {logicalHeight - INKBOX.y - INKBOX.h, INKBOX.x, INKBOX.h, INKBOX.w};
 
-    PangoFontDescription *fontDesc = pango_font_description_from_string(gPlugin->bar_text_font.c_str());
-    pango_font_description_set_size(fontDesc, scaledSize * PANGO_SCALE);
-    pango_layout_set_font_description(layout, fontDesc);
-    pango_font_description_free(fontDesc);
+    // rotation happens around the box center, so center the unrotated texture on the target rect
+    m_bTitleBox = {texBox.middle() - INKBOX.size() / 2.0, INKBOX.size()};
+    m_bTitleBox.rot = ROTATION * M_PI / 2.0;
+}
 
-    PangoContext *context = pango_layout_get_context(layout);
-    pango_context_set_base_dir(context, PANGO_DIRECTION_NEUTRAL);
+SP<STitleTexture> CHyprWindowDecorator::rasterTitle(PangoLayout *layout, const CHyprColor &color)
+{
+    PangoRectangle inkRect;
+    pango_layout_get_pixel_extents(layout, &inkRect, nullptr);
 
-    const float iconReserved = gPlugin->decoration_appicon_enabled ? (VERTICAL ? bufferSize.x : bufferSize.y) : 0;
-    const float paddingTotal = scaledBarPadding * 2 + scaledButtonsSize + iconReserved;
-    const float maxWidth = std::max(0.0f, logicalWidth - paddingTotal);
+    auto title = makeShared<STitleTexture>();
+    title->inkBox = {(double)inkRect.x, (double)inkRect.y, (double)std::max(1, inkRect.width), (double)std::max(1, inkRect.height)};
 
-    pango_layout_set_width(layout, (int)std::round(maxWidth * PANGO_SCALE));
-    pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
+    const auto &INK = title->inkBox;
+    const Vector2D TEXSIZE = INK.size();
 
-    cairo_set_source_rgba(CAIRO, COLOR.r, COLOR.g, COLOR.b, COLOR.a);
+    // the texture only covers the ink of the (ellipsized) text
+    const auto CAIROSURFACE = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, TEXSIZE.x, TEXSIZE.y);
+    const auto CAIRO = cairo_create(CAIROSURFACE);
 
-    int layoutWidth, layoutHeight;
-    pango_layout_get_size(layout, &layoutWidth, &layoutHeight);
+    // clear the pixmap
+    cairo_save(CAIRO);
+    cairo_set_operator(CAIRO, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(CAIRO);
+    cairo_restore(CAIRO);
 
-    // Use float alignment (0.0 to 1.0)
-    const float align = std::clamp(gPlugin->decoration_title_align, 0.0f, 1.0f);
+    cairo_translate(CAIRO, -INK.x, -INK.y);
 
-    const float availableWidth = logicalWidth - paddingTotal;
-    const int xOffset = std::round(scaledBarPadding + (BUTTONSRIGHT ? 0 : scaledButtonsSize) + iconReserved + (availableWidth - (float)layoutWidth / PANGO_SCALE) * align);
-    const int yOffset = std::round((logicalHeight / 2.0 - layoutHeight / PANGO_SCALE / 2.0));
+    cairo_set_source_rgba(CAIRO, color.r, color.g, color.b, color.a);
 
-    cairo_move_to(CAIRO, xOffset, yOffset);
+    cairo_move_to(CAIRO, 0, 0);
     pango_cairo_show_layout(CAIRO, layout);
 
-    g_object_unref(layout);
-
     cairo_surface_flush(CAIROSURFACE);
 
     // copy the data to an OpenGL texture we have
     const auto DATA = cairo_image_surface_get_data(CAIROSURFACE);
-    m_pTextTex->allocate();
-    glBindTexture(GL_TEXTURE_2D, m_pTextTex->m_texID);
+    title->tex = makeShared<CTexture>();
+    title->tex->allocate();
+    glBindTexture(GL_TEXTURE_2D, title->tex->m_texID);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
@@ -537,42 +549,19 @@ void CHyprWindowDecorator::renderBarTitle(const Vector2D &bufferSize, const floa
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
 #endif
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, bufferSize.x, bufferSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, DATA);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, TEXSIZE.x, TEXSIZE.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, DATA);
 
-    m_pTextTex->m_size = bufferSize;
+    title->tex->m_size = TEXSIZE;
 
     // delete cairo
     cairo_destroy(CAIRO);
     cairo_surface_destroy(CAIROSURFACE);
-}
 
-size_t CHyprWindowDecorator::getVisibleButtonCount(const Vector2D &bufferSize, const float scale)
-{
-    const bool VERTICAL = gPlugin->decoration_title_placement == "left" || gPlugin->decoration_title_placement == "right";
-    const float iconReserved = gPlugin->decoration_appicon_enabled ? bufferSize.y : 0;
-    float availableSpace = bufferSize.x - gPlugin->decoration_padding * scale * 2 - iconReserved;
-    size_t count = 0;
-
-    for (const auto &button : gPlugin->m_vButtons)
-    {
-        const float buttonSpace = ((VERTICAL ? button.size.y : button.size.x) + gPlugin->bar_button_padding) * scale;
-        if (availableSpace >= buttonSpace)
-        {
-            count++;
-            availableSpace -= buttonSpace;
-        }
-        else
-            break;
-    }
-
-    return count;
+    return title;
 }
 
-bool CHyprWindowDecorator::renderBarButtons(const Vector2D &bufferSize, const float scale)
+bool CHyprWindowDecorator::renderBarButtons(const Vector2D &bufferSize)
 {
-    const bool BUTTONSRIGHT = gPlugin->bar_buttons_alignment != "left";
-    const auto visibleCount = getVisibleButtonCount(bufferSize, scale);
-
     const auto CAIROSURFACE = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, bufferSize.x, bufferSize.y);
     const auto CAIRO = cairo_create(CAIROSURFACE);
 
@@ -582,19 +571,8 @@ bool CHyprWindowDecorator::renderBarButtons(const Vector2D &bufferSize, const fl
     cairo_paint(CAIRO);
     cairo_restore(CAIRO);
 
-    // draw buttons
-    const bool VERTICAL = gPlugin->decoration_title_placement == "left" || gPlugin->decoration_title_placement == "right";
-    double offset = gPlugin->decoration_padding * scale;
+    // buttons themselves are drawn straight from their textures in renderBarButtonsText
     bool texturesLoaded = false;
-    for (size_t i = 0; i < visibleCount; ++i)
-    {
-        auto &button = gPlugin->m_vButtons[i];
-        const auto alongSize = (VERTICAL ? button.size.y : button.size.x);
-        const auto scaledButtonSize = alongSize * scale;
-        const auto scaledButtonsPad = gPlugin->bar_button_padding * scale;
-
-        offset += scaledButtonsPad + scaledButtonSize;
-    }
 
     // copy the data to an OpenGL texture we have
     const auto DATA = cairo_image_surface_get_data(CAIROSURFACE);
@@ -611,6 +589,7 @@ bool CHyprWindowDecorator::renderBarButtons(const Vector2D &bufferSize, const fl
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, bufferSize.x, bufferSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, DATA);
 
     m_pButtonsTex->m_size = bufferSize;
+    m_bTexturesGrew = true;
 
     // delete cairo
     cairo_destroy(CAIRO);
@@ -620,43 +599,19 @@ bool CHyprWindowDecorator::renderBarButtons(const Vector2D &bufferSize, const fl
     return texturesLoaded;
 }
 
-void CHyprWindowDecorator::renderBarButtonsText(CBox *barBox, const float scale, const float a)
+void CHyprWindowDecorator::renderBarButtonsText(const CBox &decoBox, const float a)
 {
-    const bool BUTTONSRIGHT = gPlugin->bar_buttons_alignment != "left";
-    const bool VERTICAL = gPlugin->decoration_title_placement == "left" || gPlugin->decoration_title_placement == "right";
-    const auto visibleCount = getVisibleButtonCount(VERTICAL ? Vector2D((double)barBox->height, (double)barBox->width) : Vector2D((double)barBox->width, (double)barBox->height), scale);
-    const auto COORDS = cursorRelativeToBar();
-
-    const float iconReserved = gPlugin->decoration_appicon_enabled ? (VERTICAL ? barBox->width : barBox->height) : 0;
-    double offset = (gPlugin->decoration_padding * scale) + (BUTTONSRIGHT ? 0 : iconReserved);
-    float noScaleOffset = gPlugin->decoration_padding + (BUTTONSRIGHT ? 0 : iconReserved / scale);
+    // the layout was just updated for this monitor
+    const int hoveredIdx = m_layout.buttonAt(cursorRelativeToBar());
 
-    int hoveredIdx = indexToButton(COORDS);
-
-    for (size_t i = 0; i < visibleCount; ++i)
+    for (size_t i = 0; i < m_layout.buttonsPx.size(); ++i)
     {
         auto &button = gPlugin->m_vButtons[i];
-        const auto scaledButtonSizeX = button.size.x * scale;
-        const auto scaledButtonSizeY = button.size.y * scale;
-        const auto scaledButtonsPad = gPlugin->bar_button_padding * scale;
 
         // check if hovering here
         bool hovering = (hoveredIdx == (int)i);
 
-        // DEBUG_LOG("Rendering button {} at offset {}, hovering: {}", i, offset, hovering);
-
-        CBox pos;
-
-        if (!VERTICAL)
-        {
-            pos = {barBox->x + (int)std::round(BUTTONSRIGHT ? barBox->width - offset - scaledButtonSizeX : offset), (double)std::round(barBox->y + (barBox->height - scaledButtonSizeY) / 2.0), (double)std::round(scaledButtonSizeX), (double)std::round(scaledButtonSizeY)};
-        }
-        else
-        {
-            pos = {barBox->x + (int)std::round((barBox->width - scaledButtonSizeX) / 2.0), barBox->y + (int)std::round(BUTTONSRIGHT ? barBox->height - offset - scaledButtonSizeY : offset), (double)std::round(scaledButtonSizeX), (double)std::round(scaledButtonSizeY)};
-        }
-
-        noScaleOffset += gPlugin->bar_button_padding + (VERTICAL ? button.size.y : button.size.x);
+        const CBox pos = m_layout.buttonsPx[i].copy().translate(decoBox.pos());
 
         // Skip if textured button is not available
         if (button.texActive->m_texID == 0)
@@ -676,7 +631,6 @@ void CHyprWindowDecorator::renderBarButtonsText(CBox *barBox, const float scale,
         CHyprOpenGLImpl::STextureRenderData data;
         data.a = a;
         g_pHyprOpenGL->renderTexture(tex, pos, data);
-        offset += scaledButtonsPad + (VERTICAL ? scaledButtonSizeY : scaledButtonSizeX);
 
         bool currentBit = (m_iButtonHoverState & (1 << i)) != 0;
         if (hovering != currentBit)
@@ -706,6 +660,11 @@ void CHyprWindowDecorator::draw(PHLMONITOR pMonitor, const float &a)
     if (!PWINDOW->m_ruleApplicator->decorate().valueOrDefault())
         return;
 
+    gPlugin->m_pInputRouter->updateBox(this, assignedBoxGlobal());
+
+    // the pass element reports it before drawing, so the renderer can prepare the cached blur
+    updateBlur(a);
+
     auto data = CRenderPassElement::SBarData{this, a};
     g_pHyprRenderer->m_renderPass.add(makeUnique<CRenderPassElement>(data));
 }
@@ -714,14 +673,11 @@ void CHyprWindowDecorator::renderPass(PHLMONITOR pMonitor, const float &a)
 {
     const auto PWINDOW = m_pWindow.lock();
 
-    bool windowFocus = PWINDOW == Desktop::focusState()->window();
-    bool focusChanged = windowFocus != m_bWindowHasFocus;
-    if (focusChanged)
-    {
-        m_bWindowHasFocus = windowFocus;
-        m_bButtonsDirty = true;
+    m_lastDrawn = Time::steadyNow();
+
+    const bool WINDOWFOCUS = PWINDOW == Desktop::focusState()->window();
+    if (WINDOWFOCUS != m_bWindowHasFocus)
         damageEntire();
-    }
 
     const CHyprColor DEST_COLOR = m_bForcedBarColor.value_or(gPlugin->bar_color);
     if (DEST_COLOR != m_cRealBarColor->goal())
@@ -730,8 +686,6 @@ void CHyprWindowDecorator::renderPass(PHLMONITOR pMonitor, const float &a)
     CHyprColor color = m_cRealBarColor->value();
 
     color.a *= a;
-    const bool BUTTONSRIGHT = gPlugin->bar_buttons_alignment != "left";
-    const bool SHOULDBLUR = gPlugin->bar_blur && color.a < 1.F;
     const auto PWORKSPACE = PWINDOW->m_workspace;
     const auto WORKSPACEOFFSET = PWORKSPACE && !PWINDOW->m_pinned ? PWORKSPACE->m_renderOffset->value() : Vector2D();
 
@@ -755,6 +709,9 @@ void CHyprWindowDecorator::renderPass(PHLMONITOR pMonitor, const float &a)
         return;
     }
 
+    // bars warmed up while hidden find everything up to date here
+    updateTextures(pMonitor, titleBarBox, WINDOWFOCUS);
+
     g_pHyprOpenGL->scissor(titleBarBox);
 
     const int PBORDERINSET = gPlugin->decoration_inset;
@@ -787,179 +744,76 @@ void CHyprWindowDecorator::renderPass(PHLMONITOR pMonitor, const float &a)
         glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
     }
 
-    const auto &NPI = m_bWindowHasFocus ? gPlugin->activeNinepatch : gPlugin->inactiveNinepatch;
-    float border[4] = {NPI.border[0], NPI.border[1], NPI.border[2], NPI.border[3]};
-    cairo_surface_t *sourceSurface = m_bWindowHasFocus ? gPlugin->activeSurface : gPlugin->inactiveSurface;
+    // blur samples what is behind the window it is drawn for
+    const auto PREVWINDOW = g_pHyprOpenGL->m_renderData.currentWindow;
+    if (m_bBlur)
+    {
+        g_pHyprOpenGL->m_renderData.currentWindow = m_pWindow;
+        (m_bCachedBlur ? gPlugin->m_iCachedBlurFrames : gPlugin->m_iLiveBlurFrames)++;
+    }
 
-    if (sourceSurface)
+    if (gPlugin->hasNinePatch())
     {
-        if (m_bWindowSizeChanged || m_pBarFinalTex->m_texID == 0 || focusChanged || m_bNinePatchChanged)
+        if (m_pBarFinalTex->m_size == titleBarBox.size())
         {
-            const auto CAIROSURFACE = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, titleBarBox.width, titleBarBox.height);
-            const auto CAIRO = cairo_create(CAIROSURFACE);
-
-            cairo_set_operator(CAIRO, CAIRO_OPERATOR_CLEAR);
-            cairo_paint(CAIRO);
-            cairo_set_operator(CAIRO, CAIRO_OPERATOR_OVER);
-
-            const int sw = cairo_image_surface_get_width(sourceSurface);
-            const int sh = cairo_image_surface_get_height(sourceSurface);
-
-            double sx[4] = {0, border[0], sw - border[2], (double)sw};
-            double sy[4] = {0, border[1], sh - border[3], (double)sh};
-
-            double dx[4] = {0, (sx[1] - sx[0]) * pMonitor->m_scale, (double)titleBarBox.width - (sx[3] - sx[2]) * pMonitor->m_scale, (double)titleBarBox.width};
-            double dy[4] = {0, (sy[1] - sy[0]) * pMonitor->m_scale, (double)titleBarBox.height - (sy[3] - sy[2]) * pMonitor->m_scale, (double)titleBarBox.height};
-
-            for (int i = 0; i < 3; ++i)
+            CHyprOpenGLImpl::STextureRenderData data;
+            data.a = a;
+            if (m_bBlur)
             {
-                for (int j = 0; j < 3; ++j)
-                {
-                    double middleAlphaVal = (i == 1 && j == 1) ? gPlugin->ninepatch_middle_alpha : 1.0;
-                    if (middleAlphaVal <= 0)
-                        continue;
-
-                    cairo_save(CAIRO);
-                    if (middleAlphaVal < 1.0)
-                    {
-                        cairo_push_group(CAIRO);
-                    }
-
-                    bool isMiddlePatch = (i == 1 || j == 1);
-                    if (gPlugin->ninepatch_repeat && isMiddlePatch)
-                    {
-                        drawRepeatedSurface(CAIRO, sourceSurface, sx[i], sy[j], sx[i + 1] - sx[i], sy[j + 1] - sy[j], dx[i], dy[j], dx[i + 1] - dx[i], dy[j + 1] - dy[j]);
-                    }
-                    else
-                    {
-                        drawSizedSurface(CAIRO, sourceSurface, sx[i], sy[j], sx[i + 1] - sx[i], sy[j + 1] - sy[j], dx[i], dy[j], dx[i + 1] - dx[i], dy[j + 1] - dy[j]);
-                    }
-
-                    if (middleAlphaVal < 1.0)
-                    {
-                        cairo_pop_group_to_source(CAIRO);
-                        cairo_paint_with_alpha(CAIRO, middleAlphaVal);
-                    }
-                    cairo_restore(CAIRO);
-                }
+                // blurred wherever the nine-patch lets the background through
+                data.blur = true;
+                data.blurA = a;
+                data.blockBlurOptimization = !m_bCachedBlur;
             }
-
-            cairo_surface_flush(CAIROSURFACE);
-            const auto DATA = cairo_image_surface_get_data(CAIROSURFACE);
-            m_pBarFinalTex->allocate();
-            glBindTexture(GL_TEXTURE_2D, m_pBarFinalTex->m_texID);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gPlugin->ninepatch_linear_filtering ? GL_LINEAR : GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gPlugin->ninepatch_linear_filtering ? GL_LINEAR : GL_NEAREST);
-#ifndef GLES2
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_BLUE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
-#endif
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, titleBarBox.width, titleBarBox.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, DATA);
-            m_pBarFinalTex->m_size = {(double)titleBarBox.width, (double)titleBarBox.height};
-
-            cairo_destroy(CAIRO);
-            cairo_surface_destroy(CAIROSURFACE);
-            m_bNinePatchChanged = false;
+            g_pHyprOpenGL->renderTexture(m_pBarFinalTex, titleBarBox, data);
+        }
+        else if (m_pBarFinalTex->m_texID != 0)
+        {
+            // rasterized at an older size, keep the corners and stretch the rest until the resize settled
+            const auto &NPI = m_bWindowHasFocus ? gPlugin->activeNinepatch : gPlugin->inactiveNinepatch;
+            const float MARGINS[4] = {NPI.border[0] * pMonitor->m_scale, NPI.border[1] * pMonitor->m_scale, NPI.border[2] * pMonitor->m_scale,
+                                      NPI.border[3] * pMonitor->m_scale};
+            renderNinePatch(m_pBarFinalTex, titleBarBox, MARGINS, a, 1.f);
         }
+    }
+    else if (m_bBlur)
+    {
+        // a 1x1 texture of the color instead of a rect, textures can use the cached blur
+        updateBarColorTex(m_cRealBarColor->value());
+
         CHyprOpenGLImpl::STextureRenderData data;
         data.a = a;
-        g_pHyprOpenGL->renderTexture(m_pBarFinalTex, titleBarBox, data);
+        data.blur = true;
+        data.blurA = a;
+        data.blockBlurOptimization = !m_bCachedBlur;
+        data.round = (int)scaledRounding;
+        data.roundingPower = m_pWindow->roundingPower();
+        g_pHyprOpenGL->renderTexture(m_pBarColorTex, titleBarBox, data);
     }
     else
-    {
-        if (SHOULDBLUR)
-            g_pHyprOpenGL->renderRect(titleBarBox, color, {.round = (int)scaledRounding, .roundingPower = m_pWindow->roundingPower(), .blur = true, .blurA = a});
-        else
-            g_pHyprOpenGL->renderRect(titleBarBox, color, {.round = (int)scaledRounding, .roundingPower = m_pWindow->roundingPower()});
-    }
+        g_pHyprOpenGL->renderRect(titleBarBox, color, {.round = (int)scaledRounding, .roundingPower = m_pWindow->roundingPower()});
 
-    if (m_bWindowSizeChanged)
-        m_bButtonsDirty = true;
+    g_pHyprOpenGL->m_renderData.currentWindow = PREVWINDOW;
 
-    const auto P = gPlugin->decoration_padding;
-    CBox topBarBox;
-    if (gPlugin->decoration_title_placement == "top")
-    {
-        topBarBox = {titleBarBox.x + (int)std::round((gPlugin->decoration_offset_left + NPI.padding[0] + P) * pMonitor->m_scale),
-                     titleBarBox.y,
-                     (double)std::round(titleBarBox.width - (gPlugin->decoration_offset_left + gPlugin->decoration_offset_right + NPI.padding[0] + NPI.padding[2] + 2 * P) * pMonitor->m_scale),
-                     (double)std::round((gPlugin->decoration_offset_top + NPI.padding[1] + P) * pMonitor->m_scale)};
-    }
-    else if (gPlugin->decoration_title_placement == "bottom")
-    {
-        topBarBox = {titleBarBox.x + (int)std::round((gPlugin->decoration_offset_left + NPI.padding[0] + P) * pMonitor->m_scale),
-                     titleBarBox.y + (int)std::round(titleBarBox.height - (gPlugin->decoration_offset_bottom + NPI.padding[3] + P) * pMonitor->m_scale),
-                     (double)std::round(titleBarBox.width - (gPlugin->decoration_offset_left + gPlugin->decoration_offset_right + NPI.padding[0] + NPI.padding[2] + 2 * P) * pMonitor->m_scale),
-                     (double)std::round((gPlugin->decoration_offset_bottom + NPI.padding[3] + P) * pMonitor->m_scale)};
-    }
-    else if (gPlugin->decoration_title_placement == "left")
-    {
-        topBarBox = {titleBarBox.x,
-                     titleBarBox.y + (int)std::round((gPlugin->decoration_offset_top + NPI.padding[1] + P) * pMonitor->m_scale),
-                     (double)std::round((gPlugin->decoration_offset_left + NPI.padding[0] + P) * pMonitor->m_scale),
-                     (double)std::round(titleBarBox.height - (gPlugin->decoration_offset_top + gPlugin->decoration_offset_bottom + NPI.padding[1] + NPI.padding[3] + 2 * P) * pMonitor->m_scale)};
-    }
-    else if (gPlugin->decoration_title_placement == "right")
-    {
-        topBarBox = {titleBarBox.x + (int)std::round(titleBarBox.width - (gPlugin->decoration_offset_right + NPI.padding[2] + P) * pMonitor->m_scale),
-                     titleBarBox.y + (int)std::round((gPlugin->decoration_offset_top + NPI.padding[1] + P) * pMonitor->m_scale),
-                     (double)std::round((gPlugin->decoration_offset_right + NPI.padding[2] + P) * pMonitor->m_scale),
-                     (double)std::round(titleBarBox.height - (gPlugin->decoration_offset_top + gPlugin->decoration_offset_bottom + NPI.padding[1] + NPI.padding[3] + 2 * P) * pMonitor->m_scale)};
-    }
+    const CBox topBarBox = m_layout.barPx.copy().translate(titleBarBox.pos());
 
     // render app icon
     if (gPlugin->decoration_appicon_enabled)
     {
-        std::string appId = PWINDOW->m_initialClass;
+        const int iconSizeDesired = (int)m_layout.iconPx.w;
 
-        int iconSizeDesired = (int)(std::max(topBarBox.width, topBarBox.height) * 0.6); // Reasonable size check
-        if (gPlugin->decoration_title_placement == "top" || gPlugin->decoration_title_placement == "bottom")
-            iconSizeDesired = (int)(topBarBox.height * 0.6);
-        else
-            iconSizeDesired = (int)(topBarBox.width * 0.6);
-
-        if (appId != m_szLastAppId || m_pAppIconTex->m_texID == 0 || (int)m_pAppIconTex->m_size.x != iconSizeDesired)
+        if (m_pAppIconTex)
         {
-            m_szLastAppId = appId;
-
-            // Reset the texture
-            if (m_pAppIconTex->m_texID != 0)
-            {
-                m_pAppIconTex->destroyTexture();
-                m_pAppIconTex = makeShared<CTexture>();
-            }
-
-            loadAppIcon(appId, m_pAppIconTex, iconSizeDesired);
-        }
-
-        if (m_pAppIconTex->m_texID != 0)
-        {
-            int iconPad;
-            CBox iconBox;
-            const auto ATEXSIZE = m_pAppIconTex->m_size;
-            if (gPlugin->decoration_title_placement == "top" || gPlugin->decoration_title_placement == "bottom")
-            {
-                iconPad = (int)std::round(topBarBox.height * 0.2);
-                iconBox = {topBarBox.x + iconPad + gPlugin->decoration_appicon_offset.x * pMonitor->m_scale, topBarBox.y + (int)std::round((topBarBox.height - ATEXSIZE.y) / 2.0) + gPlugin->decoration_appicon_offset.y * pMonitor->m_scale, ATEXSIZE.x, ATEXSIZE.y};
-            }
-            else
-            {
-                iconPad = (int)std::round(topBarBox.width * 0.2);
-                iconBox = {topBarBox.x + (int)std::round((topBarBox.width - ATEXSIZE.x) / 2.0) + gPlugin->decoration_appicon_offset.x * pMonitor->m_scale, topBarBox.y + iconPad + gPlugin->decoration_appicon_offset.y * pMonitor->m_scale, ATEXSIZE.x, ATEXSIZE.y};
-            }
+            // the texture is square and up to a bucket larger than the slot, draw it at the slot size
+            const Vector2D ICONSIZE = {(double)iconSizeDesired, (double)iconSizeDesired};
+            const CBox ICONSLOT = m_layout.iconPx.copy().translate(titleBarBox.pos());
+            const CBox iconBox = {(ICONSLOT.middle() - ICONSIZE / 2.0).round(), ICONSIZE};
             CHyprOpenGLImpl::STextureRenderData data;
             data.a = a;
             g_pHyprOpenGL->renderTexture(m_pAppIconTex, iconBox, data);
         }
     }
 
-    // render title
-    if (gPlugin->decoration_title_enabled && (m_szLastTitle != PWINDOW->m_title || m_bWindowSizeChanged || m_pTextTex->m_texID == 0 || m_bTitleColorChanged))
-    {
-        m_szLastTitle = PWINDOW->m_title;
-        renderBarTitle(Vector2D((double)topBarBox.width, (double)topBarBox.height), pMonitor->m_scale);
-    }
-
     if (ROUNDING)
     {
         // cleanup stencil
@@ -970,19 +824,14 @@ void CHyprWindowDecorator::renderPass(PHLMONITOR pMonitor, const float &a)
         glStencilFunc(GL_ALWAYS, 1, 0xFF);
     }
 
-    if (gPlugin->decoration_title_enabled && m_pTextTex->m_texID)
+    if (gPlugin->decoration_title_enabled && m_pTitleTex)
     {
-        // render title texture at full bar size (text is already positioned within the texture)
-        CBox textBox = {topBarBox.x, topBarBox.y, (double)m_pTextTex->m_size.x, (double)m_pTextTex->m_size.y};
+        // the title texture only covers the text, place it within the bar
+        // vertical bars draw the same horizontal texture rotated
+        CBox textBox = m_bTitleBox.copy().translate(topBarBox.pos());
         CHyprOpenGLImpl::STextureRenderData data;
         data.a = a;
-        g_pHyprOpenGL->renderTexture(m_pTextTex, textBox, data);
-    }
-
-    if (m_bButtonsDirty || m_bWindowSizeChanged)
-    {
-        const bool VERTICAL = gPlugin->decoration_title_placement == "left" || gPlugin->decoration_title_placement == "right";
-        m_bButtonsDirty = renderBarButtons(VERTICAL ? Vector2D((double)topBarBox.height, (double)topBarBox.width) : Vector2D((double)topBarBox.width, (double)topBarBox.height), pMonitor->m_scale);
+        g_pHyprOpenGL->renderTexture(m_pTitleTex->tex, textBox, data);
     }
 
     if (m_pButtonsTex->m_texID)
@@ -994,11 +843,16 @@ void CHyprWindowDecorator::renderPass(PHLMONITOR pMonitor, const float &a)
 
     g_pHyprOpenGL->scissor(nullptr);
 
-    renderBarButtonsText(&topBarBox, pMonitor->m_scale, a);
+    renderBarButtonsText(titleBarBox, a);
 
     m_bWindowSizeChanged = false;
-    m_bTitleColorChanged = false;
-    m_bButtonsDirty = false;
+
+    if (m_bTexturesGrew)
+    {
+        m_bTexturesGrew = false;
+        gPlugin->m_lastVisibleRaster = m_lastDrawn;
+        gPlugin->enforceTextureBudget();
+    }
 
     // dynamic updates change the extents
     if (m_iLastHeight != gPlugin->decoration_offset_top)
@@ -1008,6 +862,309 @@ void CHyprWindowDecorator::renderPass(PHLMONITOR pMonitor, const float &a)
     }
 }
 
+void CHyprWindowDecorator::updateTextures(PHLMONITOR pMonitor, const CBox &titleBarBox, bool focused)
+{
+    const auto PWINDOW = m_pWindow.lock();
+
+    const bool FOCUSCHANGED = focused != m_bWindowHasFocus;
+    if (FOCUSCHANGED)
+    {
+        m_bWindowHasFocus = focused;
+        m_bButtonsDirty = true;
+    }
+
+    // everything is rasterized for where an animation is heading, in-flight frames draw it stretched
+    const CBox TARGETBOX = targetBarBox(pMonitor, titleBarBox);
+    const Vector2D TARGETSIZE = TARGETBOX.size() == titleBarBox.size() ? m_bAssignedBox.size() : TARGETBOX.size() / pMonitor->m_scale;
+
+    // while the size keeps changing the old textures are stretched, see renderNinePatch
+    const auto NOW = Time::steadyNow();
+    if (TARGETBOX.size() != m_vLastBarSize)
+    {
+        if (m_vLastBarSize != Vector2D{})
+            m_lastResize = NOW;
+        m_vLastBarSize = TARGETBOX.size();
+    }
+
+    const auto SETTLE = std::chrono::milliseconds(gPlugin->resize_settle_ms);
+    const bool RESIZING = NOW - m_lastResize < SETTLE;
+    if (RESIZING)
+    {
+        m_pResizeTimer->updateTimeout(std::chrono::duration_cast<std::chrono::milliseconds>(SETTLE - (NOW - m_lastResize)));
+        m_iDeferredResizes++;
+    }
+
+    if (TARGETBOX.size() != titleBarBox.size())
+        m_iAnimatedFrames++;
+
+    const bool BARSTALE = m_pBarFinalTex->m_size != TARGETBOX.size() && !RESIZING;
+    if (gPlugin->hasNinePatch() && (m_pBarFinalTex->m_texID == 0 || BARSTALE || FOCUSCHANGED || m_bNinePatchChanged))
+    {
+        // with low_memory the pixels may need decoding again
+        if (cairo_surface_t *sourceSurface = gPlugin->ninePatchSurface(m_bWindowHasFocus))
+            rasterNinePatch(sourceSurface, TARGETBOX, pMonitor->m_scale);
+    }
+
+    // drawing goes by the current size, rasterizing by the target one
+    const bool LAYOUTCHANGED = m_layout.update(m_bAssignedBox.size(), pMonitor->m_scale, m_bWindowHasFocus);
+    m_rasterLayout.update(TARGETSIZE, pMonitor->m_scale, m_bWindowHasFocus);
+
+    if (gPlugin->decoration_appicon_enabled)
+    {
+        const std::string &appId = PWINDOW->m_initialClass;
+
+        // small size changes during animations keep the loaded icon
+        const int ICONBUCKET = iconSizeBucket((int)m_rasterLayout.iconPx.w);
+
+        // windows without an icon would otherwise search for it again every frame
+        if (appId != m_szLastAppId || ICONBUCKET != m_iLastIconSize)
+        {
+            m_szLastAppId = appId;
+            m_iLastIconSize = ICONBUCKET;
+            // null until the worker is done, the slot stays empty meanwhile
+            m_pAppIconTex = gPlugin->m_pIconLoader->get(appId, ICONBUCKET);
+        }
+    }
+
+    bool titleLaidOut = false;
+    const bool BARRESIZED = m_vLastTitleSize != TARGETBOX.size();
+    // the title keeps its texture and layout until a resize settled
+    if (gPlugin->decoration_title_enabled && !(RESIZING && m_pTitleTex) && (m_szLastTitle != PWINDOW->m_title || BARRESIZED || !m_pTitleTex || m_bTitleColorChanged))
+    {
+        if (BARRESIZED || !m_pTitleTex || m_bTitleColorChanged || shouldUpdateTitle(PWINDOW->m_title))
+        {
+            m_szLastTitle = PWINDOW->m_title;
+            m_szPendingTitle = m_szLastTitle;
+            m_bTitleUpdatePending = false;
+            m_lastTitleUpdate = Time::steadyNow();
+            m_vLastTitleSize = TARGETBOX.size();
+            m_bTitleColorChanged = false;
+            renderBarTitle(pMonitor->m_scale);
+            titleLaidOut = true;
+        }
+    }
+
+    // otherwise it only follows the bar
+    if (!titleLaidOut && LAYOUTCHANGED && m_pTitleTex)
+        placeTitle(pMonitor->m_scale);
+
+    const auto BUTTONSBUF = barAxes(m_rasterLayout.barPx.size(), m_rasterLayout.vertical);
+    if (m_bButtonsDirty || (m_pButtonsTex->m_size != BUTTONSBUF && !RESIZING))
+    {
+        renderBarButtons(BUTTONSBUF);
+        m_bButtonsDirty = false;
+    }
+}
+
+CBox CHyprWindowDecorator::targetBarBox(PHLMONITOR pMonitor, const CBox &titleBarBox)
+{
+    const auto PWINDOW = m_pWindow.lock();
+    if (!PWINDOW->m_realSize->isBeingAnimated() && !PWINDOW->m_realPosition->isBeingAnimated())
+        return titleBarBox;
+
+    // the bar grows and shrinks with the window, its offset from the window stays the same
+    CBox box = m_bAssignedBox;
+    box.w += PWINDOW->m_realSize->goal().x - PWINDOW->m_realSize->value().x;
+    box.h += PWINDOW->m_realSize->goal().y - PWINDOW->m_realSize->value().y;
+    // the same rounding the bar gets once the animation is done
+    box.translate(PWINDOW->m_realPosition->goal() - pMonitor->m_position);
+    box.scale(pMonitor->m_scale).round();
+
+    return box.w >= 1 && box.h >= 1 ? box : titleBarBox;
+}
+
+void CHyprWindowDecorator::rasterNinePatch(cairo_surface_t *sourceSurface, const CBox &titleBarBox, const float scale)
+{
+    const auto &NPI = m_bWindowHasFocus ? gPlugin->activeNinepatch : gPlugin->inactiveNinepatch;
+    float border[4] = {NPI.border[0], NPI.border[1], NPI.border[2], NPI.border[3]};
+
+    const auto CAIROSURFACE = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, titleBarBox.width, titleBarBox.height);
+    const auto CAIRO = cairo_create(CAIROSURFACE);
+
+    cairo_set_operator(CAIRO, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(CAIRO);
+    cairo_set_operator(CAIRO, CAIRO_OPERATOR_OVER);
+
+    const int sw = cairo_image_surface_get_width(sourceSurface);
+    const int sh = cairo_image_surface_get_height(sourceSurface);
+
+    double sx[4] = {0, border[0], sw - border[2], (double)sw};
+    double sy[4] = {0, border[1], sh - border[3], (double)sh};
+
+    double dx[4] = {0, (sx[1] - sx[0]) * scale, (double)titleBarBox.width - (sx[3] - sx[2]) * scale, (double)titleBarBox.width};
+    double dy[4] = {0, (sy[1] - sy[0]) * scale, (double)titleBarBox.height - (sy[3] - sy[2]) * scale, (double)titleBarBox.height};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            double middleAlphaVal = (i == 1 && j == 1) ? gPlugin->ninepatch_middle_alpha : 1.0;
+            if (middleAlphaVal <= 0)
+                continue;
+
+            cairo_save(CAIRO);
+            if (middleAlphaVal < 1.0)
+            {
+                cairo_push_group(CAIRO);
+            }
+
+            bool isMiddlePatch = (i == 1 || j == 1);
+            if (gPlugin->ninepatch_repeat && isMiddlePatch)
+            {
+                drawRepeatedSurface(CAIRO, sourceSurface, sx[i], sy[j], sx[i + 1] - sx[i], sy[j + 1] - sy[j], dx[i], dy[j], dx[i + 1] - dx[i], dy[j + 1] - dy[j]);
+            }
+            else
+            {
+                drawSizedSurface(CAIRO, sourceSurface, sx[i], sy[j], sx[i + 1] - sx[i], sy[j + 1] - sy[j], dx[i], dy[j], dx[i + 1] - dx[i], dy[j + 1] - dy[j]);
+            }
+
+            if (middleAlphaVal < 1.0)
+            {
+                cairo_pop_group_to_source(CAIRO);
+                cairo_paint_with_alpha(CAIRO, middleAlphaVal);
+            }
+            cairo_restore(CAIRO);
+        }
+    }
+
+    cairo_surface_flush(CAIROSURFACE);
+    const auto DATA = cairo_image_surface_get_data(CAIROSURFACE);
+
+    // opaque themes need no blur behind them
+    const int STRIDE = cairo_image_surface_get_stride(CAIROSURFACE);
+    m_bBarTranslucent = false;
+    for (int y = 0; y < titleBarBox.height && !m_bBarTranslucent; ++y)
+    {
+        const auto *ROW = (const uint32_t *)(DATA + (size_t)y * STRIDE);
+        m_bBarTranslucent = std::any_of(ROW, ROW + (int)titleBarBox.width, [](uint32_t px)
+                                        { return (px >> 24) != 0xFF; });
+    }
+
+    m_pBarFinalTex->allocate();
+    glBindTexture(GL_TEXTURE_2D, m_pBarFinalTex->m_texID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gPlugin->ninepatch_linear_filtering ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gPlugin->ninepatch_linear_filtering ? GL_LINEAR : GL_NEAREST);
+#ifndef GLES2
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_BLUE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+#endif
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, titleBarBox.width, titleBarBox.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, DATA);
+    m_pBarFinalTex->m_size = {(double)titleBarBox.width, (double)titleBarBox.height};
+
+    cairo_destroy(CAIRO);
+    cairo_surface_destroy(CAIROSURFACE);
+    m_bNinePatchChanged = false;
+    m_bTexturesGrew = true;
+}
+
+void CHyprWindowDecorator::renderNinePatch(SP<CTexture> tex, const CBox &box, const float margins[4], const float a, const float middleAlpha)
+{
+    const Vector2D TEXSIZE = tex->m_size;
+
+    // corners can't overlap, on either side
+    const double L = std::min<double>(margins[0], std::min(TEXSIZE.x, box.w) / 2.0);
+    const double T = std::min<double>(margins[1], std::min(TEXSIZE.y, box.h) / 2.0);
+    const double R = std::min<double>(margins[2], std::min(TEXSIZE.x, box.w) / 2.0);
+    const double B = std::min<double>(margins[3], std::min(TEXSIZE.y, box.h) / 2.0);
+
+    const double sx[4] = {0, L, TEXSIZE.x - R, TEXSIZE.x};
+    const double sy[4] = {0, T, TEXSIZE.y - B, TEXSIZE.y};
+    const double dx[4] = {box.x, box.x + L, box.x + box.w - R, box.x + box.w};
+    const double dy[4] = {box.y, box.y + T, box.y + box.h - B, box.y + box.h};
+
+    // every cell samples its own rect of the texture, corners 1:1 and edges stretched along one axis
+    for (int i = 0; i < 3; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            const CBox CELL = {dx[i], dy[j], dx[i + 1] - dx[i], dy[j + 1] - dy[j]};
+            if (CELL.w <= 0 || CELL.h <= 0 || sx[i + 1] <= sx[i] || sy[j + 1] <= sy[j])
+                continue;
+
+            g_pHyprOpenGL->m_renderData.primarySurfaceUVTopLeft = {sx[i] / TEXSIZE.x, sy[j] / TEXSIZE.y};
+            g_pHyprOpenGL->m_renderData.primarySurfaceUVBottomRight = {sx[i + 1] / TEXSIZE.x, sy[j + 1] / TEXSIZE.y};
+
+            CHyprOpenGLImpl::STextureRenderData data;
+            data.a = (i == 1 && j == 1) ? a * middleAlpha : a;
+            if (m_bBlur)
+            {
+                data.blur = true;
+                data.blurA = a;
+                data.blockBlurOptimization = !m_bCachedBlur;
+            }
+            g_pHyprOpenGL->renderTexture(tex, CELL, data);
+        }
+    }
+
+    g_pHyprOpenGL->m_renderData.primarySurfaceUVTopLeft = Vector2D(-1, -1);
+    g_pHyprOpenGL->m_renderData.primarySurfaceUVBottomRight = Vector2D(-1, -1);
+}
+
+void CHyprWindowDecorator::updateBlur(const float a)
+{
+    static auto *const PBLUR = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(gPlugin->m_pHandle, "decoration:blur:enabled")->getDataStaticPtr();
+
+    m_bBlur = false;
+    m_bCachedBlur = false;
+
+    if (!**PBLUR || !gPlugin->bar_blur)
+        return;
+
+    if (gPlugin->hasNinePatch())
+        m_bBlur = m_bBarTranslucent;
+    else
+        m_bBlur = m_cRealBarColor->value().a * a < 1.F;
+
+    // the precomputed blur only has the layers below windows in it, Hyprland knows when that is enough
+    m_bCachedBlur = m_bBlur && g_pHyprOpenGL->shouldUseNewBlurOptimizations(nullptr, m_pWindow.lock());
+}
+
+void CHyprWindowDecorator::updateBarColorTex(const CHyprColor &color)
+{
+    if (m_pBarColorTex->m_texID && color == m_cBarColorTexColor)
+        return;
+
+    // premultiplied like every other texture here
+    const uint8_t PIXEL[4] = {(uint8_t)std::round(color.r * color.a * 255), (uint8_t)std::round(color.g * color.a * 255), (uint8_t)std::round(color.b * color.a * 255),
+                              (uint8_t)std::round(color.a * 255)};
+
+    m_pBarColorTex->allocate();
+    glBindTexture(GL_TEXTURE_2D, m_pBarColorTex->m_texID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PIXEL);
+    m_pBarColorTex->m_size = {1, 1};
+
+    m_cBarColorTexColor = color;
+}
+
+bool CHyprWindowDecorator::warmUp()
+{
+    const auto PWINDOW = m_pWindow.lock();
+    if (m_hidden || !validMapped(PWINDOW) || !PWINDOW->m_ruleApplicator->decorate().valueOrDefault())
+        return false;
+
+    const auto PMONITOR = PWINDOW->m_monitor.lock();
+    const auto PWORKSPACE = PWINDOW->m_workspace;
+    if (!PMONITOR || !PWORKSPACE)
+        return false;
+
+    // where the bar will be once its workspace is shown, without any slide in progress
+    CBox titleBarBox = m_bAssignedBox.copy().translate(PWINDOW->m_realPosition->goal() - PMONITOR->m_position);
+    titleBarBox.scale(PMONITOR->m_scale).round();
+    if (titleBarBox.w < 1 || titleBarBox.h < 1)
+        return false;
+
+    // the workspace refocuses this window when it comes back
+    const bool FOCUSED = PWORKSPACE->m_lastFocusedWindow.lock() == PWINDOW;
+
+    updateTextures(PMONITOR, titleBarBox, FOCUSED);
+
+    const bool RASTERIZED = m_bTexturesGrew;
+    m_bTexturesGrew = false;
+    return RASTERIZED;
+}
+
 eDecorationType CHyprWindowDecorator::getDecorationType()
 {
     return DECORATION_CUSTOM;
@@ -1035,22 +1192,7 @@ bool CHyprWindowDecorator::isMouseOnBar()
 
 bool CHyprWindowDecorator::isPointOnBar(Vector2D COORDS)
 {
-    const auto BOX = assignedBoxGlobal();
-
-    if (!VECINRECT(COORDS, 0, 0, BOX.w, BOX.h))
-        return false;
-
-    const auto &NPI = gPlugin->activeNinepatch.defined ? gPlugin->activeNinepatch : gPlugin->inactiveNinepatch;
-    const auto P = gPlugin->decoration_padding;
-    const auto L = gPlugin->decoration_offset_left + NPI.padding[0] + P;
-    const auto T = gPlugin->decoration_offset_top + NPI.padding[1] + P;
-    const auto R = gPlugin->decoration_offset_right + NPI.padding[2] + P;
-    const auto B = gPlugin->decoration_offset_bottom + NPI.padding[3] + P;
-
-    if (COORDS.x >= L && COORDS.x < BOX.w - R && COORDS.y >= T && COORDS.y < BOX.h - B)
-        return false;
-
-    return true;
+    return layout().isOnDecoration(COORDS);
 }
 
 eDecorationLayer CHyprWindowDecorator::getDecorationLayer()
@@ -1080,6 +1222,15 @@ CBox CHyprWindowDecorator::assignedBoxGlobal()
     return box;
 }
 
+std::string CHyprWindowDecorator::getStats()
+{
+    const auto PWINDOW = m_pWindow.lock();
+    const size_t SHARED = (m_pTitleTex ? textureBytes(m_pTitleTex->tex) : 0) + textureBytes(m_pAppIconTex);
+    return std::format("{}: title changes {}, suppressed rasters {}, title interval {}ms, stretched resize frames {}, animated frames {}, textures {}KB own + {}KB shared\n",
+                       PWINDOW ? PWINDOW->m_class : "?", m_iTitleChanges, m_iSuppressedTitleRasters, titleUpdateInterval().count(), m_iDeferredResizes,
+                       m_iAnimatedFrames, ownTextureBytes() / 1024, SHARED / 1024);
+}
+
 PHLWINDOW CHyprWindowDecorator::getOwner()
 {
     return m_pWindow.lock();
@@ -1108,10 +1259,55 @@ void CHyprWindowDecorator::updateRules()
         m_bTitleColorChanged = true;
 }
 
+void CHyprWindowDecorator::onIconReady(const std::string &appId, int size, SP<CTexture> tex)
+{
+    if (appId != m_szLastAppId || size != m_iLastIconSize)
+        return;
+
+    m_pAppIconTex = tex;
+    damageEntire();
+}
+
+void CHyprWindowDecorator::onIconsChanged()
+{
+    if (m_pAppIconTex)
+        return;
+
+    // asks the loader again on the next draw
+    m_iLastIconSize = -1;
+    damageEntire();
+}
+
+size_t CHyprWindowDecorator::ownTextureBytes() const
+{
+    return textureBytes(m_pBarFinalTex) + textureBytes(m_pButtonsTex);
+}
+
+size_t CHyprWindowDecorator::releaseTextures()
+{
+    const size_t FREED = ownTextureBytes();
+
+    m_pBarFinalTex = makeShared<CTexture>();
+    m_pButtonsTex = makeShared<CTexture>();
+    m_pTitleTex.reset();
+    m_pAppIconTex.reset();
+
+    // everything gets rasterized or looked up again on the next draw
+    m_bButtonsDirty = true;
+    m_iLastIconSize = -1;
+
+    return FREED;
+}
+
+Time::steady_tp CHyprWindowDecorator::lastDrawn() const
+{
+    return m_lastDrawn;
+}
+
 void CHyprWindowDecorator::invalidateTextures()
 {
     m_pBarFinalTex = makeShared<CTexture>();
-    m_pTextTex = makeShared<CTexture>();
+    m_pTitleTex.reset();
     m_pButtonsTex = makeShared<CTexture>();
 
     // Mark everything as dirty to force full re-render
@@ -1120,6 +1316,7 @@ void CHyprWindowDecorator::invalidateTextures()
     m_bTitleColorChanged = true;
     m_bNinePatchChanged = true;
     m_szLastTitle = ""; // Force title re-render
+    m_iLastIconSize = -1; // icon theme may have changed
 
     damageEntire();
 }
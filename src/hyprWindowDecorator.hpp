@@ -9,6 +9,7 @@
 #include <hyprland/src/desktop/rule/windowRule/WindowRule.hpp>
 #include <hyprland/src/helpers/AnimatedVariable.hpp>
 #include <hyprland/src/helpers/time/Time.hpp>
+#include <hyprland/src/managers/eventLoop/EventLoopTimer.hpp>
 #include <cairo/cairo.h>
 #include "plugin.hpp"
 
@@ -16,6 +17,12 @@
 #include <hyprland/src/managers/input/InputManager.hpp>
 #undef private
 
+// title changes per second above which a window counts as churning
+constexpr int TITLE_CHURN_THRESHOLD = 10;
+constexpr int TITLE_UPDATE_INTERVAL_MAX = 1000;
+// title changes are counted per window of this length, the previous window still counts towards the back off
+constexpr auto TITLE_CHURN_WINDOW = std::chrono::seconds(1);
+
 class CHyprWindowDecorator : public IHyprWindowDecoration
 {
 public:
@@ -48,6 +55,24 @@ public:
 
   void invalidateTextures();
 
+  // an icon requested from the icon loader finished decoding
+  void onIconReady(const std::string &appId, int size, SP<CTexture> tex);
+  // the indexes icons are resolved with changed, a missing icon may exist now
+  void onIconsChanged();
+
+  // textures only this bar uses, titles and icons are accounted by their caches
+  size_t ownTextureBytes() const;
+  // drops every texture, they are rasterized again when the bar is drawn. Returns the own bytes freed
+  size_t releaseTextures();
+  Time::steady_tp lastDrawn() const;
+
+  // rasterizes what the bar will need once its workspace is shown, true if anything was rasterized
+  bool warmUp();
+  // last warm-up round of the plugin this bar was looked at in
+  uint64_t m_iWarmUpRound = 0;
+
+  std::string getStats();
+
   CHyprWindowDecorator *m_self;
 
 private:
@@ -57,12 +82,27 @@ private:
 
   CBox m_bAssignedBox;
 
-  SP<CTexture> m_pTextTex;
+  SP<STitleTexture> m_pTitleTex;
+  // title texture placement within the bar, rotated for vertical bars
+  CBox m_bTitleBox;
   SP<CTexture> m_pButtonsTex;
   SP<CTexture> m_pBarFinalTex;
+  // 1x1 of the blurred bar color, drawn stretched
+  SP<CTexture> m_pBarColorTex;
+  CHyprColor m_cBarColorTexColor;
+  // the rasterized nine-patch lets the background through somewhere
+  bool m_bBarTranslucent = true;
+  // decided once per frame in draw, the pass element reports it to the renderer
+  bool m_bBlur = false;
+  // blur from Hyprland's precomputed blur instead of blurring the framebuffer live
+  bool m_bCachedBlur = false;
 
   SP<CTexture> m_pAppIconTex;
+  Time::steady_tp m_lastDrawn;
+  // something was rasterized this frame, the texture budget may be exceeded now
+  bool m_bTexturesGrew = false;
   std::string m_szLastAppId;
+  int m_iLastIconSize = -1;
 
   bool m_bWindowSizeChanged = false;
   bool m_hidden = false;
@@ -81,14 +121,26 @@ private:
   bool isMouseOnBar();
 
   void renderPass(PHLMONITOR, float const &a);
-  void renderBarTitle(const Vector2D &bufferSize, const float scale);
-  void renderText(SP<CTexture> out, const std::string &text, const CHyprColor &color, const Vector2D &bufferSize, const float scale, const int fontSize);
-  bool renderBarButtons(const Vector2D &bufferSize, const float scale);
-  void renderBarButtonsText(CBox *barBox, const float scale, const float a);
+  // brings every texture up to date for the bar box, does not draw
+  void updateTextures(PHLMONITOR pMonitor, const CBox &titleBarBox, bool focused);
+  void rasterNinePatch(cairo_surface_t *sourceSurface, const CBox &titleBarBox, const float scale);
+  // titleBarBox as it will be once the window's size and position animations are done
+  CBox targetBarBox(PHLMONITOR pMonitor, const CBox &titleBarBox);
+  void renderBarTitle(const float scale);
+  // positions the current title texture in the bar, without laying it out again
+  void placeTitle(const float scale);
+  SP<STitleTexture> rasterTitle(PangoLayout *layout, const CHyprColor &color);
+  Vector2D renderText(SP<CTexture> out, const std::string &text, const CHyprColor &color, const Vector2D &bufferSize, const float scale, const int fontSize);
+  bool renderBarButtons(const Vector2D &bufferSize);
+  void renderBarButtonsText(const CBox &decoBox, const float a);
+  // draws tex into box with margins (in texture pixels) kept 1:1 and the rest stretched, blurred behind like the bar
   void renderNinePatch(SP<CTexture> tex, const CBox &box, const float margins[4], const float a, const float middleAlpha);
   void damageOnButtonHover();
+  void updateBlur(const float a);
+  void updateBarColorTex(const CHyprColor &color);
 
   bool inputIsValid();
+  bool hasGrab();
   bool isPointOnBar(Vector2D COORDS);
   void onMouseButton(SCallbackInfo &info, IPointer::SButtonEvent e);
   void onTouchDown(SCallbackInfo &info, ITouch::SDownEvent e);
@@ -101,17 +153,40 @@ private:
   void handleMovement();
   int indexToButton(Vector2D COORDS);
 
-  CBox assignedBoxGlobal();
-
-  SP<HOOK_CALLBACK_FN> m_pMouseButtonCallback;
-  SP<HOOK_CALLBACK_FN> m_pTouchDownCallback;
-  SP<HOOK_CALLBACK_FN> m_pTouchUpCallback;
+  SDecorationLayout m_layout;
+  // up to date for the size, focus and monitor the window currently has
+  const SDecorationLayout &layout();
+  // the same for the size textures are rasterized at, differs from m_layout during animations
+  SDecorationLayout m_rasterLayout;
 
-  SP<HOOK_CALLBACK_FN> m_pTouchMoveCallback;
-  SP<HOOK_CALLBACK_FN> m_pMouseMoveCallback;
+  CBox assignedBoxGlobal();
 
   std::string m_szLastTitle;
+  // bar size the title was laid out for
   Vector2D m_vLastTitleSize;
+  // pango size of the title text, for placing it without the layout
+  Vector2D m_vTitleLayoutSize;
+
+  // interactive resize, nothing is rasterized until the size held for resize_settle_ms
+  Vector2D m_vLastBarSize;
+  Time::steady_tp m_lastResize;
+  size_t m_iDeferredResizes = 0;
+  size_t m_iAnimatedFrames = 0;
+  SP<CEventLoopTimer> m_pResizeTimer;
+
+  // title change coalescing
+  std::string m_szPendingTitle;
+  bool m_bTitleUpdatePending = false;
+  Time::steady_tp m_lastTitleUpdate;
+  Time::steady_tp m_titleChurnStart;
+  int m_iTitleChurn = 0;
+  int m_iLastTitleChurn = 0;
+  size_t m_iTitleChanges = 0;
+  size_t m_iSuppressedTitleRasters = 0;
+  SP<CEventLoopTimer> m_pTitleTimer;
+
+  std::chrono::milliseconds titleUpdateInterval();
+  bool shouldUpdateTitle(const std::string &title);
 
   bool m_bDraggingThis = false;
   bool m_bTouchEv = false;
@@ -127,7 +202,6 @@ private:
   // for dynamic updates
   int m_iLastHeight = 0;
 
-  size_t getVisibleButtonCount(const Vector2D &bufferSize, const float scale);
-
   friend class CRenderPassElement;
+  friend class CInputRouter;
 };
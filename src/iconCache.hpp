@@ -0,0 +1,34 @@
+#pragma once
+
+#include <hyprland/src/render/Texture.hpp>
+#include <string>
+#include "sharedCache.hpp"
+
+// app icons are loaded for sizes rounded up to this many pixels
+constexpr int ICON_SIZE_BUCKET = 8;
+// decoded icons no window currently uses that are kept around
+constexpr size_t ICON_TEXTURE_CACHE_IDLE = 32;
+
+inline int iconSizeBucket(int size)
+{
+    return (size + ICON_SIZE_BUCKET - 1) / ICON_SIZE_BUCKET * ICON_SIZE_BUCKET;
+}
+
+struct SIconTextureKey
+{
+    std::string path;
+    int size = 0; // bucketed pixel size
+
+    bool operator==(const SIconTextureKey &) const = default;
+};
+
+struct SIconTextureKeyHash
+{
+    size_t operator()(const SIconTextureKey &k) const
+    {
+        return std::hash<std::string>{}(k.path) ^ (std::hash<int>{}(k.size) + 0x9e3779b9);
+    }
+};
+
+// Decoded app icons, shared by every window showing the same icon at the same size bucket.
+using CIconTextureCache = CSharedCache<SIconTextureKey, CTexture, SIconTextureKeyHash>;
@@ -0,0 +1,452 @@
+#include "iconDiskCache.hpp"
+
+#include <hyprland/src/managers/eventLoop/EventLoopManager.hpp>
+#include <hyprland/src/managers/eventLoop/EventLoopTimer.hpp>
+#include <hyprland/src/debug/log/Logger.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "desktopIndex.hpp"
+
+constexpr char ICON_DISK_CACHE_MAGIC[4] = {'H', 'D', 'I', 'C'};
+// bump whenever the layout below changes
+constexpr uint32_t ICON_DISK_CACHE_VERSION = 1;
+// larger icons only get their path cached
+constexpr int ICON_DISK_CACHE_MAX_PIXEL_SIZE = 128;
+// new entries usually come in bursts when a session is restored
+constexpr auto ICON_DISK_CACHE_FLUSH_DELAY = std::chrono::seconds(2);
+
+// File layout, native endianness:
+//   magic, u32 version, string theme, u32 dir count, dirs, u32 entry count, entries
+//   dir:   string path, i64 mtime
+//   entry: string app id, i32 size, string path, u32 width, u32 height, padding to 4, pixels
+//   string: u32 length, bytes
+
+struct SCacheReader
+{
+    const uint8_t *base = nullptr;
+    const uint8_t *p = nullptr;
+    const uint8_t *end = nullptr;
+    bool ok = true;
+
+    const uint8_t *bytes(size_t n)
+    {
+        if (!ok || (size_t)(end - p) < n)
+        {
+            ok = false;
+            return nullptr;
+        }
+
+        const auto RESULT = p;
+        p += n;
+        return RESULT;
+    }
+
+    template <typename T>
+    T get()
+    {
+        T value{};
+        if (const auto DATA = bytes(sizeof(T)))
+            std::memcpy(&value, DATA, sizeof(T));
+        return value;
+    }
+
+    std::string str()
+    {
+        const auto LEN = get<uint32_t>();
+        const auto DATA = bytes(LEN);
+        return DATA ? std::string((const char *)DATA, LEN) : "";
+    }
+
+    void align()
+    {
+        bytes((4 - (p - base) % 4) % 4);
+    }
+};
+
+struct SCacheWriter
+{
+    std::string out;
+
+    template <typename T>
+    void put(T value)
+    {
+        out.append((const char *)&value, sizeof(T));
+    }
+
+    void str(const std::string &value)
+    {
+        put<uint32_t>(value.size());
+        out += value;
+    }
+
+    void align()
+    {
+        out.append((4 - out.size() % 4) % 4, '\0');
+    }
+};
+
+static std::string cacheDir()
+{
+    const char *xdgCacheHome = getenv("XDG_CACHE_HOME");
+    if (xdgCacheHome && xdgCacheHome[0] != '\0')
+        return std::string(xdgCacheHome) + "/hyprdecor/";
+
+    const char *home = getenv("HOME");
+    return home ? std::string(home) + "/.cache/hyprdecor/" : "";
+}
+
+CIconDiskCache::CIconDiskCache()
+{
+    const auto DIR = cacheDir();
+    if (DIR.empty())
+        return;
+
+    m_szPath = DIR + "icons.cache";
+    m_vDirs = currentDirs();
+
+    m_pFlushTimer = makeShared<CEventLoopTimer>(std::nullopt, [this](SP<CEventLoopTimer> self, void *data)
+                                                { flush(); }, nullptr);
+    g_pEventLoopManager->addTimer(m_pFlushTimer);
+
+    if (!map())
+        return;
+
+    m_bValid = parse();
+    if (!m_bValid)
+        m_mEntries.clear();
+
+    m_iLoaded = m_mEntries.size();
+}
+
+CIconDiskCache::~CIconDiskCache()
+{
+    if (m_pFlushTimer)
+        g_pEventLoopManager->removeTimer(m_pFlushTimer);
+
+    flush();
+
+    m_mEntries.clear();
+    if (m_pMap)
+        munmap(m_pMap, m_iMapSize);
+}
+
+bool CIconDiskCache::map()
+{
+    const int FD = open(m_szPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (FD < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(FD, &st) == 0 && st.st_size > 0)
+    {
+        m_pMap = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, FD, 0);
+        if (m_pMap == MAP_FAILED)
+            m_pMap = nullptr;
+        else
+            m_iMapSize = st.st_size;
+    }
+
+    close(FD);
+
+    return m_pMap;
+}
+
+void CIconDiskCache::remap()
+{
+    void *const OLDMAP = m_pMap;
+    const size_t OLDSIZE = m_iMapSize;
+    m_pMap = nullptr;
+    m_iMapSize = 0;
+
+    // entries point into the old mapping until parsed again
+    m_mEntries.clear();
+    if (map() && !parse())
+        m_mEntries.clear();
+
+    if (OLDMAP)
+        munmap(OLDMAP, OLDSIZE);
+}
+
+size_t CIconDiskCache::ownedBytes() const
+{
+    size_t bytes = 0;
+    for (const auto &[_, entry] : m_mEntries)
+        bytes += entry.ownedPixels.size();
+    return bytes;
+}
+
+void CIconDiskCache::setLowMemory(bool lowMemory)
+{
+    m_bLowMemory = lowMemory;
+}
+
+std::vector<CIconDiskCache::SDirStamp> CIconDiskCache::currentDirs()
+{
+    std::vector<SDirStamp> dirs;
+
+    auto stamp = [&dirs](const std::string &path)
+    {
+        struct stat st;
+        int64_t mtime = -1;
+        if (stat(path.c_str(), &st) == 0)
+            mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+        dirs.push_back(SDirStamp{path, mtime});
+    };
+
+    auto subdirs = [](const std::string &path)
+    {
+        std::vector<std::string> result;
+        std::error_code ec;
+        for (const auto &entry : std::filesystem::directory_iterator(path, ec))
+        {
+            if (entry.is_directory(ec))
+                result.push_back(entry.path().string());
+        }
+
+        // directory order is not stable
+        std::ranges::sort(result);
+        return result;
+    };
+
+    // icon roots, every theme in them and the theme's size dirs, the same dirs the icon theme index watches.
+    // those are two levels deep, either size/context or context/size, an icon copied in only changes that dir
+    auto stampIcons = [&](const std::string &root)
+    {
+        stamp(root);
+
+        for (const auto &theme : subdirs(root))
+        {
+            stamp(theme);
+
+            for (const auto &dir : subdirs(theme))
+            {
+                stamp(dir);
+
+                for (const auto &sizeDir : subdirs(dir))
+                    stamp(sizeDir);
+            }
+        }
+    };
+
+    const char *home = getenv("HOME");
+    if (home)
+        stampIcons(std::string(home) + "/.icons");
+
+    for (const auto &dir : xdgDataDirs())
+    {
+        stamp(dir + "/applications");
+        stamp(dir + "/pixmaps");
+        stampIcons(dir + "/icons");
+    }
+
+    if (home)
+        stamp(std::string(home) + "/.local/share/flatpak/exports/share/applications");
+    stamp("/var/lib/flatpak/exports/share/applications");
+
+    return dirs;
+}
+
+std::string CIconDiskCache::entryKey(const std::string &appId, int size)
+{
+    return std::to_string(size) + ":" + appId;
+}
+
+bool CIconDiskCache::parse()
+{
+    SCacheReader reader;
+    reader.base = (const uint8_t *)m_pMap;
+    reader.p = reader.base;
+    reader.end = reader.base + m_iMapSize;
+
+    const auto MAGIC = reader.bytes(sizeof(ICON_DISK_CACHE_MAGIC));
+    if (!MAGIC || std::memcmp(MAGIC, ICON_DISK_CACHE_MAGIC, sizeof(ICON_DISK_CACHE_MAGIC)) != 0)
+        return false;
+
+    if (reader.get<uint32_t>() != ICON_DISK_CACHE_VERSION)
+        return false;
+
+    m_szTheme = reader.str();
+
+    const auto DIRCOUNT = reader.get<uint32_t>();
+    if (!reader.ok || DIRCOUNT != m_vDirs.size())
+        return false;
+
+    for (const auto &dir : m_vDirs)
+    {
+        SDirStamp stored;
+        stored.path = reader.str();
+        stored.mtime = reader.get<int64_t>();
+        if (!reader.ok || stored != dir)
+            return false;
+    }
+
+    const auto ENTRYCOUNT = reader.get<uint32_t>();
+    for (uint32_t i = 0; i < ENTRYCOUNT && reader.ok; ++i)
+    {
+        SEntry entry;
+        entry.appId = reader.str();
+        entry.size = reader.get<int32_t>();
+        entry.path = reader.str();
+        entry.width = reader.get<uint32_t>();
+        entry.height = reader.get<uint32_t>();
+        reader.align();
+
+        if (entry.width > ICON_DISK_CACHE_MAX_PIXEL_SIZE || entry.height > ICON_DISK_CACHE_MAX_PIXEL_SIZE)
+            return false;
+
+        if (entry.width > 0 && entry.height > 0)
+            entry.pixels = reader.bytes((size_t)entry.width * entry.height * 4);
+
+        if (!reader.ok)
+            return false;
+
+        m_mEntries[entryKey(entry.appId, entry.size)] = std::move(entry);
+    }
+
+    return reader.ok;
+}
+
+void CIconDiskCache::setTheme(const std::string &theme)
+{
+    m_bThemeKnown = true;
+
+    if (theme == m_szTheme)
+        return;
+
+    m_szTheme = theme;
+
+    if (!m_mEntries.empty())
+    {
+        m_mEntries.clear();
+        scheduleFlush();
+    }
+}
+
+std::optional<CIconDiskCache::SHit> CIconDiskCache::lookup(const std::string &appId, int size)
+{
+    if (!m_bThemeKnown)
+        return std::nullopt;
+
+    const auto IT = m_mEntries.find(entryKey(appId, size));
+    if (IT == m_mEntries.end())
+    {
+        m_iMisses++;
+        return std::nullopt;
+    }
+
+    m_iHits++;
+
+    const auto &ENTRY = IT->second;
+    return SHit{ENTRY.path, ENTRY.width, ENTRY.height, ENTRY.pixels};
+}
+
+void CIconDiskCache::record(const std::string &appId, int size, const std::string &path, cairo_surface_t *surface)
+{
+    if (m_szPath.empty() || !m_bThemeKnown)
+        return;
+
+    SEntry entry;
+    entry.appId = appId;
+    entry.size = size;
+    entry.path = path;
+
+    if (surface && cairo_image_surface_get_format(surface) == CAIRO_FORMAT_ARGB32)
+    {
+        const int WIDTH = cairo_image_surface_get_width(surface);
+        const int HEIGHT = cairo_image_surface_get_height(surface);
+
+        if (WIDTH <= ICON_DISK_CACHE_MAX_PIXEL_SIZE && HEIGHT <= ICON_DISK_CACHE_MAX_PIXEL_SIZE)
+        {
+            cairo_surface_flush(surface);
+
+            const auto DATA = cairo_image_surface_get_data(surface);
+            const int STRIDE = cairo_image_surface_get_stride(surface);
+
+            entry.ownedPixels.resize((size_t)WIDTH * HEIGHT * 4);
+            for (int y = 0; y < HEIGHT; ++y)
+                std::memcpy(entry.ownedPixels.data() + (size_t)y * WIDTH * 4, DATA + (size_t)y * STRIDE, (size_t)WIDTH * 4);
+
+            entry.width = WIDTH;
+            entry.height = HEIGHT;
+            entry.pixels = entry.ownedPixels.data();
+        }
+    }
+
+    m_mEntries[entryKey(appId, size)] = std::move(entry);
+    scheduleFlush();
+}
+
+void CIconDiskCache::scheduleFlush()
+{
+    m_bDirty = true;
+    if (m_pFlushTimer)
+        m_pFlushTimer->updateTimeout(ICON_DISK_CACHE_FLUSH_DELAY);
+}
+
+void CIconDiskCache::flush()
+{
+    if (!m_bDirty || m_szPath.empty())
+        return;
+
+    m_bDirty = false;
+
+    SCacheWriter writer;
+    writer.out.append(ICON_DISK_CACHE_MAGIC, sizeof(ICON_DISK_CACHE_MAGIC));
+    writer.put<uint32_t>(ICON_DISK_CACHE_VERSION);
+    writer.str(m_szTheme);
+
+    writer.put<uint32_t>(m_vDirs.size());
+    for (const auto &dir : m_vDirs)
+    {
+        writer.str(dir.path);
+        writer.put<int64_t>(dir.mtime);
+    }
+
+    writer.put<uint32_t>(m_mEntries.size());
+    for (const auto &[_, entry] : m_mEntries)
+    {
+        writer.str(entry.appId);
+        writer.put<int32_t>(entry.size);
+        writer.str(entry.path);
+        writer.put<uint32_t>(entry.pixels ? entry.width : 0);
+        writer.put<uint32_t>(entry.pixels ? entry.height : 0);
+        writer.align();
+        if (entry.pixels)
+            writer.out.append((const char *)entry.pixels, (size_t)entry.width * entry.height * 4);
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(m_szPath).parent_path(), ec);
+
+    // written next to it and renamed over, the old file may still be mapped
+    const auto TMPPATH = m_szPath + ".tmp";
+    {
+        std::ofstream file(TMPPATH, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return;
+
+        file.write(writer.out.data(), writer.out.size());
+        if (!file.good())
+            return;
+    }
+
+    std::filesystem::rename(TMPPATH, m_szPath, ec);
+    if (ec)
+    {
+        Log::logger->log(Log::ERR, "[HYPRDECOR] Failed to write icon cache {}: {}", m_szPath, ec.message());
+        return;
+    }
+
+    m_iWrites++;
+
+    // the pixels just written are paged in from the file again when needed
+    if (m_bLowMemory)
+        remap();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <hyprland/src/helpers/memory/Memory.hpp>
+#include <cairo/cairo.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CEventLoopTimer;
+
+// Resolved app icons from earlier sessions, kept in $XDG_CACHE_HOME/hyprdecor/.
+// Maps (app id, size) to the icon path and, for small sizes, its premultiplied
+// pixels. The file is mapped at startup and thrown away as a whole when any of
+// the application or icon dirs changed since it was written.
+class CIconDiskCache
+{
+public:
+    CIconDiskCache();
+    ~CIconDiskCache();
+
+    CIconDiskCache(const CIconDiskCache &) = delete;
+    CIconDiskCache &operator=(const CIconDiskCache &) = delete;
+
+    struct SHit
+    {
+        // empty for apps without an icon
+        std::string path;
+        int width = 0;
+        int height = 0;
+        // ARGB32, width * 4 stride, null when only the path is known
+        const uint8_t *pixels = nullptr;
+    };
+
+    // entries are only handed out once the theme they were resolved with is known
+    void setTheme(const std::string &theme);
+
+    std::optional<SHit> lookup(const std::string &appId, int size);
+
+    // surface may be null for apps without an icon, written out a bit later
+    void record(const std::string &appId, int size, const std::string &path, cairo_surface_t *surface);
+
+    void flush();
+
+    // after each flush the file is mapped again, dropping the copies of recorded pixels
+    void setLowMemory(bool lowMemory);
+    // pixels recorded this session, not yet backed by the mapped file
+    size_t ownedBytes() const;
+
+    bool m_bValid = false;
+    size_t m_iLoaded = 0;
+    size_t m_iHits = 0;
+    size_t m_iMisses = 0;
+    size_t m_iWrites = 0;
+
+    size_t size() const
+    {
+        return m_mEntries.size();
+    }
+
+private:
+    struct SEntry
+    {
+        std::string appId;
+        int size = 0;
+        std::string path;
+        int width = 0;
+        int height = 0;
+        // into the mapped file or ownedPixels
+        const uint8_t *pixels = nullptr;
+        std::vector<uint8_t> ownedPixels;
+    };
+
+    struct SDirStamp
+    {
+        std::string path;
+        // -1 when missing, so a dir showing up invalidates as well
+        int64_t mtime = -1;
+
+        bool operator==(const SDirStamp &) const = default;
+    };
+
+    static std::vector<SDirStamp> currentDirs();
+    static std::string entryKey(const std::string &appId, int size);
+
+    bool map();
+    void remap();
+    bool parse();
+    void scheduleFlush();
+
+    std::string m_szPath;
+    std::string m_szTheme;
+    bool m_bThemeKnown = false;
+    bool m_bDirty = false;
+    bool m_bLowMemory = false;
+
+    // stamped when the session started, entries from a later change are dropped next start
+    std::vector<SDirStamp> m_vDirs;
+    std::unordered_map<std::string, SEntry> m_mEntries;
+
+    void *m_pMap = nullptr;
+    size_t m_iMapSize = 0;
+
+    SP<CEventLoopTimer> m_pFlushTimer;
+};
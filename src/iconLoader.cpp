@@ -0,0 +1,393 @@
+#include "iconLoader.hpp"
+
+#include <hyprland/src/managers/eventLoop/EventLoopManager.hpp>
+#include <hyprland/src/managers/eventLoop/EventLoopTimer.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "hyprWindowDecorator.hpp"
+#include "util.hpp"
+
+// source icons kept around for rescaling, a 256px one takes about 350KB
+constexpr size_t ICON_MIP_CHAIN_CACHE = 16;
+// how often apps without an icon check whether one got installed, matches the icon theme index's own check
+constexpr auto ICON_RECHECK_INTERVAL = std::chrono::seconds(5);
+
+static int onEventFdReadable(int fd, uint32_t mask, void *data)
+{
+    ((CIconLoader *)data)->onCompletions();
+    return 0;
+}
+
+CIconLoader::CIconLoader(CDesktopFileIndex &desktopIndex, CIconThemeIndex &iconThemes, CIconTextureCache &textures)
+    : m_desktopIndex(desktopIndex), m_iconThemes(iconThemes), m_textures(textures)
+{
+    m_iEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_iEventFd >= 0)
+        m_pEventSource = wl_event_loop_add_fd(g_pCompositor->m_wlEventLoop, m_iEventFd, WL_EVENT_READABLE, onEventFdReadable, this);
+
+    m_pRecheckTimer = makeShared<CEventLoopTimer>(std::nullopt, [this](SP<CEventLoopTimer> self, void *data)
+                                                  { onRecheckTimer(); }, nullptr);
+    g_pEventLoopManager->addTimer(m_pRecheckTimer);
+
+    m_thread = std::thread([this]()
+                           { workerMain(); });
+}
+
+CIconLoader::~CIconLoader()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cv.notify_one();
+
+    if (m_thread.joinable())
+        m_thread.join();
+
+    if (m_pRecheckTimer)
+        g_pEventLoopManager->removeTimer(m_pRecheckTimer);
+
+    if (m_pEventSource)
+        wl_event_source_remove(m_pEventSource);
+    if (m_iEventFd >= 0)
+        close(m_iEventFd);
+
+    for (auto &result : m_dDone)
+    {
+        if (result.surface)
+            cairo_surface_destroy(result.surface);
+    }
+}
+
+SP<CTexture> CIconLoader::get(const std::string &appId, int size)
+{
+    if (appId.empty())
+        return nullptr;
+
+    SRequestKey key{appId, size};
+
+    const uint64_t INDEXGENERATION = indexGeneration();
+
+    const auto RESOLVED = m_mResolved.find(key);
+    if (RESOLVED != m_mResolved.end())
+    {
+        const bool CURRENT = RESOLVED->second.indexGeneration == INDEXGENERATION;
+
+        if (CURRENT && RESOLVED->second.path.empty())
+            return nullptr;
+
+        if (CURRENT)
+        {
+            if (auto tex = m_textures.get(SIconTextureKey{RESOLVED->second.path, size}))
+                return tex;
+        }
+
+        // evicted since or resolved against an older index, look it up again
+        m_mResolved.erase(RESOLVED);
+    }
+
+    if (m_sPending.contains(key))
+        return nullptr;
+
+    SJob job{key, m_iGeneration, "", m_limits, m_bLowMemory};
+
+    // known from an earlier session, icons with pixels are up on this very frame.
+    // the file was validated against the dirs as they were at startup, so only until an index changed
+    const auto HIT = INDEXGENERATION == 0 ? m_diskCache.lookup(appId, size) : std::nullopt;
+    if (HIT)
+    {
+        if (HIT->path.empty())
+        {
+            m_mResolved[key] = SResolved{"", 0};
+            scheduleRecheck();
+            return nullptr;
+        }
+
+        if (HIT->pixels)
+        {
+            const SIconTextureKey TEXKEY{HIT->path, size};
+            auto tex = m_textures.get(TEXKEY);
+            if (!tex)
+            {
+                const auto SURFACE = cairo_image_surface_create_for_data((unsigned char *)HIT->pixels, CAIRO_FORMAT_ARGB32, HIT->width, HIT->height, HIT->width * 4);
+                tex = makeShared<CTexture>();
+                uploadSurface(SURFACE, tex, true);
+                cairo_surface_destroy(SURFACE);
+                m_textures.insert(TEXKEY, tex);
+            }
+
+            m_mResolved[key] = SResolved{HIT->path, 0};
+            return tex;
+        }
+
+        job.path = HIT->path;
+    }
+
+    m_sPending.insert(key);
+    m_iJobs++;
+    queue(std::move(job));
+
+    return nullptr;
+}
+
+void CIconLoader::queue(SJob &&job)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_dJobs.push_back(std::move(job));
+    }
+    m_cv.notify_one();
+}
+
+uint64_t CIconLoader::indexGeneration() const
+{
+    return m_desktopIndex.m_iChanges + m_iconThemes.m_iChanges;
+}
+
+void CIconLoader::checkIndexes()
+{
+    // results still in flight during a change come back with the old generation, so this checks every entry each time
+    const uint64_t GENERATION = indexGeneration();
+    const auto ERASED = std::erase_if(m_mResolved, [GENERATION](const auto &entry)
+                                      { return entry.second.indexGeneration != GENERATION; });
+    if (!ERASED)
+        return;
+
+    // bars with an icon keep it, the others only ask again when told to
+    for (auto bar : gPlugin->m_vBars)
+    {
+        if (bar)
+            bar->onIconsChanged();
+    }
+}
+
+void CIconLoader::scheduleRecheck()
+{
+    if (m_bRecheckScheduled || !m_pRecheckTimer)
+        return;
+
+    m_bRecheckScheduled = true;
+    m_pRecheckTimer->updateTimeout(ICON_RECHECK_INTERVAL);
+}
+
+void CIconLoader::onRecheckTimer()
+{
+    m_bRecheckScheduled = false;
+
+    // desktop files are followed through inotify, this catches those changes right away
+    checkIndexes();
+
+    const bool MISSING = std::ranges::any_of(m_mResolved, [](const auto &entry)
+                                             { return entry.second.path.empty(); });
+    if (!MISSING || m_bRecheckQueued)
+        return;
+
+    // icon themes are only checked for changes when they are used, which happens on the worker
+    SJob job;
+    job.recheck = true;
+    m_bRecheckQueued = true;
+    queue(std::move(job));
+}
+
+void CIconLoader::setLimits(const SDecodeLimits &limits)
+{
+    m_limits = limits;
+}
+
+void CIconLoader::setLowMemory(bool lowMemory)
+{
+    m_bLowMemory = lowMemory;
+    m_diskCache.setLowMemory(lowMemory);
+}
+
+void CIconLoader::setTheme(const std::string &theme)
+{
+    m_diskCache.setTheme(theme);
+
+    if (m_szTheme == theme)
+        return;
+
+    // the first theme is the one everything so far was resolved with
+    if (m_szTheme)
+    {
+        m_iGeneration++;
+        m_mResolved.clear();
+        m_sPending.clear();
+    }
+
+    m_szTheme = theme;
+}
+
+std::string CIconLoader::resolve(const SRequestKey &key)
+{
+    const auto ICONNAME = m_desktopIndex.iconFor(key.appId);
+    if (ICONNAME.empty())
+        return "";
+
+    // If already an absolute path
+    if (ICONNAME[0] == '/')
+        return std::filesystem::exists(ICONNAME) ? ICONNAME : "";
+
+    return m_iconThemes.lookup(ICONNAME, key.size);
+}
+
+cairo_surface_t *CIconLoader::decode(const std::string &path, int size, const SDecodeLimits &limits, bool keepChain)
+{
+    auto it = m_mMipChains.find(path);
+    if (it == m_mMipChains.end())
+    {
+        SImage image;
+        const auto RESULT = decodePng(path, limits, true, image);
+        if (RESULT == DECODE_TOO_LARGE)
+        {
+            m_iRejected++;
+            Log::logger->log(Log::WARN, "[HYPRDECOR] Icon {} is larger than image_max_decode_mb, not loading it", path);
+            return nullptr;
+        }
+
+        if (RESULT == DECODE_FAILED)
+            return nullptr;
+
+        if (RESULT == DECODE_REDUCED)
+        {
+            m_iReduced++;
+            Log::logger->log(Log::WARN, "[HYPRDECOR] Icon {} is larger than image_max_size, reduced to {}x{}", path, image.width, image.height);
+        }
+
+        if (m_mMipChains.size() >= ICON_MIP_CHAIN_CACHE)
+        {
+            const auto OLDEST = std::ranges::min_element(m_mMipChains, {}, [](const auto &e)
+                                                         { return e.second.lastUsed; });
+            m_iMipChainBytes -= OLDEST->second.chain.bytes();
+            m_mMipChains.erase(OLDEST);
+        }
+
+        // no icon slot is smaller than a bucket
+        it = m_mMipChains.emplace(path, SMipChainEntry{buildMipChain(std::move(image), ICON_SIZE_BUCKET)}).first;
+        m_iMipChainBytes += it->second.chain.bytes();
+        m_iMipBuilds++;
+    }
+    else
+        m_iMipHits++;
+
+    it->second.lastUsed = ++m_iMipTick;
+    const auto SURFACE = scaleFromMipChain(it->second.chain, size);
+
+    // other sizes of this icon will decode it again
+    if (!keepChain)
+    {
+        m_mMipChains.clear();
+        m_iMipChainBytes = 0;
+    }
+
+    return SURFACE;
+}
+
+void CIconLoader::workerMain()
+{
+    while (true)
+    {
+        SJob job;
+        {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [this]()
+                      { return m_bStop || !m_dJobs.empty(); });
+            if (m_bStop)
+                return;
+
+            job = std::move(m_dJobs.front());
+            m_dJobs.pop_front();
+        }
+
+        SResult result{job};
+        if (job.recheck)
+            m_iconThemes.refresh();
+        else
+        {
+            // read before resolving, a change that lands meanwhile makes it look stale rather than current
+            if (job.path.empty())
+                result.indexGeneration = indexGeneration();
+            result.path = job.path.empty() ? resolve(job.key) : job.path;
+            if (result.path.ends_with(".png"))
+                result.surface = decode(result.path, job.key.size, job.limits, !job.lowMemory);
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_dDone.push_back(std::move(result));
+        }
+
+        // EAGAIN means the counter is saturated, the main thread wakes up and drains the queue then anyway
+        const uint64_t ONE = 1;
+        if (write(m_iEventFd, &ONE, sizeof(ONE)) < 0 && errno != EAGAIN)
+            Log::logger->log(Log::ERR, "[HYPRDECOR] Failed to signal a loaded icon: {}", strerror(errno));
+    }
+}
+
+void CIconLoader::onCompletions()
+{
+    // EAGAIN when there was nothing to reset, the queue is checked regardless
+    uint64_t count = 0;
+    if (read(m_iEventFd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        Log::logger->log(Log::ERR, "[HYPRDECOR] Failed to read the icon loader eventfd: {}", strerror(errno));
+
+    std::deque<SResult> done;
+    {
+        std::lock_guard lock(m_mutex);
+        done.swap(m_dDone);
+    }
+
+    for (auto &result : done)
+    {
+        if (result.job.recheck)
+        {
+            m_bRecheckQueued = false;
+            checkIndexes();
+            // keeps going for as long as some app is left without an icon
+            scheduleRecheck();
+            continue;
+        }
+
+        m_iCompletions++;
+
+        const auto &KEY = result.job.key;
+
+        if (result.job.generation != m_iGeneration)
+        {
+            m_iDiscarded++;
+            if (result.surface)
+                cairo_surface_destroy(result.surface);
+            continue;
+        }
+
+        m_sPending.erase(KEY);
+        const auto &RESOLVED = m_mResolved[KEY] = SResolved{result.surface ? result.path : "", result.indexGeneration};
+        m_diskCache.record(KEY.appId, KEY.size, RESOLVED.path, result.surface);
+
+        if (!result.surface)
+        {
+            scheduleRecheck();
+            continue;
+        }
+
+        // another app id may have brought in the same icon meanwhile
+        const SIconTextureKey TEXKEY{result.path, KEY.size};
+        auto tex = m_textures.get(TEXKEY);
+        if (!tex)
+        {
+            g_pHyprRenderer->makeEGLCurrent();
+            tex = makeShared<CTexture>();
+            uploadSurface(result.surface, tex, true);
+            m_textures.insert(TEXKEY, tex);
+        }
+
+        cairo_surface_destroy(result.surface);
+
+        for (auto bar : gPlugin->m_vBars)
+            bar->onIconReady(KEY.appId, KEY.size, tex);
+    }
+}
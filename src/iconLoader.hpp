@@ -0,0 +1,166 @@
+#pragma once
+
+#include <hyprland/src/render/Texture.hpp>
+#include <cairo/cairo.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "iconCache.hpp"
+#include "iconDiskCache.hpp"
+#include "imageScale.hpp"
+#include "pngDecoder.hpp"
+
+class CDesktopFileIndex;
+class CIconThemeIndex;
+class CEventLoopTimer;
+struct wl_event_source;
+
+// Resolves and decodes app icons on a worker thread so opening a window never
+// waits on the filesystem. Textures are uploaded on the main thread once the
+// pixels are ready, until then decorations leave the icon slot empty.
+class CIconLoader
+{
+public:
+    CIconLoader(CDesktopFileIndex &desktopIndex, CIconThemeIndex &iconThemes, CIconTextureCache &textures);
+    ~CIconLoader();
+
+    CIconLoader(const CIconLoader &) = delete;
+    CIconLoader &operator=(const CIconLoader &) = delete;
+
+    // The icon if it is ready, otherwise it gets queued and bars are told once it is.
+    // size should already be bucketed.
+    SP<CTexture> get(const std::string &appId, int size);
+
+    // forgets resolved icons when the theme changed
+    void setTheme(const std::string &theme);
+
+    // applies to jobs queued from now on
+    void setLimits(const SDecodeLimits &limits);
+    // mip chains are dropped once the icon is scaled instead of kept for other sizes
+    void setLowMemory(bool lowMemory);
+
+    // called from the event loop when the worker finished something
+    void onCompletions();
+
+    size_t m_iJobs = 0;
+    size_t m_iCompletions = 0;
+    size_t m_iDiscarded = 0;
+    // counted on the worker
+    std::atomic<size_t> m_iMipBuilds = 0;
+    std::atomic<size_t> m_iMipHits = 0;
+    std::atomic<size_t> m_iReduced = 0;
+    std::atomic<size_t> m_iRejected = 0;
+    std::atomic<size_t> m_iMipChainBytes = 0;
+
+    size_t pending() const
+    {
+        return m_sPending.size();
+    }
+
+    const CIconDiskCache &diskCache() const
+    {
+        return m_diskCache;
+    }
+
+private:
+    struct SRequestKey
+    {
+        std::string appId;
+        int size = 0;
+
+        bool operator==(const SRequestKey &) const = default;
+    };
+
+    struct SRequestKeyHash
+    {
+        size_t operator()(const SRequestKey &k) const
+        {
+            return std::hash<std::string>{}(k.appId) ^ (std::hash<int>{}(k.size) + 0x9e3779b9);
+        }
+    };
+
+    struct SResolved
+    {
+        // empty for apps without an icon
+        std::string path;
+        // sum of the index changes when it was resolved, 0 for entries from the disk cache
+        uint64_t indexGeneration = 0;
+    };
+
+    struct SJob
+    {
+        SRequestKey key;
+        // jobs queued before a theme change are dropped when they complete
+        uint64_t generation = 0;
+        // already known from the disk cache, only decoding is left
+        std::string path;
+        SDecodeLimits limits;
+        bool lowMemory = false;
+        // nothing to resolve, only gives the icon theme index a chance to notice new icons
+        bool recheck = false;
+    };
+
+    struct SResult
+    {
+        SJob job;
+        std::string path;
+        cairo_surface_t *surface = nullptr;
+        uint64_t indexGeneration = 0;
+    };
+
+    struct SMipChainEntry
+    {
+        SMipChain chain;
+        uint64_t lastUsed = 0;
+    };
+
+    void workerMain();
+    void queue(SJob &&job);
+    std::string resolve(const SRequestKey &key);
+    uint64_t indexGeneration() const;
+    // drops resolutions made before the desktop or icon theme index changed,
+    // bars without an icon are told to ask again
+    void checkIndexes();
+    // while some apps have no icon, the indexes are checked for changes every now and then
+    void scheduleRecheck();
+    void onRecheckTimer();
+    // scaled from the icon's mip chain, which is only decoded and built once
+    cairo_surface_t *decode(const std::string &path, int size, const SDecodeLimits &limits, bool keepChain);
+
+    CDesktopFileIndex &m_desktopIndex;
+    CIconThemeIndex &m_iconThemes;
+    CIconTextureCache &m_textures;
+    CIconDiskCache m_diskCache;
+
+    // main thread only
+    std::unordered_map<SRequestKey, SResolved, SRequestKeyHash> m_mResolved;
+    std::unordered_set<SRequestKey, SRequestKeyHash> m_sPending;
+    uint64_t m_iGeneration = 0;
+    SP<CEventLoopTimer> m_pRecheckTimer;
+    bool m_bRecheckScheduled = false;
+    bool m_bRecheckQueued = false;
+    std::optional<std::string> m_szTheme;
+    SDecodeLimits m_limits;
+    bool m_bLowMemory = false;
+
+    // worker only, by icon path
+    std::unordered_map<std::string, SMipChainEntry> m_mMipChains;
+    uint64_t m_iMipTick = 0;
+
+    // shared with the worker
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<SJob> m_dJobs;
+    std::deque<SResult> m_dDone;
+    bool m_bStop = false;
+
+    int m_iEventFd = -1;
+    wl_event_source *m_pEventSource = nullptr;
+    std::thread m_thread;
+};
@@ -0,0 +1,365 @@
+#include "iconThemeIndex.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+
+#include "desktopIndex.hpp"
+
+// Used when no theme is configured, hicolor is where apps install their own icons.
+static const std::vector<std::string> DEFAULT_THEMES = {"hicolor", "breeze", "oxygen", "Adwaita", "Papirus"};
+
+// how often lookups check whether the indexed theme dirs changed
+constexpr auto ICON_THEME_CHECK_INTERVAL = std::chrono::seconds(5);
+
+static std::string trim(const std::string &str)
+{
+    const auto BEGIN = str.find_first_not_of(" \t\r");
+    if (BEGIN == std::string::npos)
+        return "";
+
+    return str.substr(BEGIN, str.find_last_not_of(" \t\r") - BEGIN + 1);
+}
+
+static std::vector<std::string> splitList(const std::string &str)
+{
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (start <= str.size())
+    {
+        const auto END = std::min(str.find(',', start), str.size());
+        const auto ITEM = trim(str.substr(start, END - start));
+        if (!ITEM.empty())
+            result.push_back(ITEM);
+        start = END + 1;
+    }
+    return result;
+}
+
+static int toInt(const std::string &str, int fallback)
+{
+    try
+    {
+        return std::stoi(str);
+    }
+    catch (std::exception &e)
+    {
+        return fallback;
+    }
+}
+
+void CIconThemeIndex::setTheme(const std::string &theme)
+{
+    std::lock_guard lock(m_pendingMutex);
+
+    if (theme == m_szPendingTheme)
+        return;
+
+    m_szPendingTheme = theme;
+    m_iGeneration++;
+}
+
+void CIconThemeIndex::invalidate()
+{
+    m_iGeneration++;
+}
+
+size_t CIconThemeIndex::size() const
+{
+    return m_iSize;
+}
+
+bool CIconThemeIndex::stale()
+{
+    const auto NOW = Time::steadyNow();
+    if (NOW - m_lastCheck < ICON_THEME_CHECK_INTERVAL)
+        return false;
+
+    m_lastCheck = NOW;
+
+    std::error_code ec;
+    for (const auto &[path, mtime] : m_vWatched)
+    {
+        if (std::filesystem::last_write_time(path, ec) != mtime)
+            return true;
+    }
+
+    return false;
+}
+
+void CIconThemeIndex::build()
+{
+    m_iBuilds++;
+
+    m_vRoots.clear();
+    m_vChain.clear();
+    m_mPixmaps.clear();
+    m_vWatched.clear();
+
+    // ~/.icons comes first, then icons in every XDG data dir
+    if (const char *home = getenv("HOME"))
+        m_vRoots.push_back(std::string(home) + "/.icons/");
+    for (const auto &dir : xdgDataDirs())
+        m_vRoots.push_back(dir + "/icons/");
+
+    if (m_szTheme.empty())
+    {
+        for (const auto &theme : DEFAULT_THEMES)
+            loadTheme(theme);
+    }
+    else
+    {
+        loadTheme(m_szTheme);
+        // hicolor is the fallback of every theme per spec
+        loadTheme("hicolor");
+    }
+
+    std::error_code ec;
+    for (const auto &dir : xdgDataDirs())
+    {
+        for (const auto &file : std::filesystem::directory_iterator(dir + "/pixmaps/", ec))
+        {
+            const auto PATH = file.path();
+            if (PATH.extension() == ".png")
+                m_mPixmaps.emplace(PATH.stem().string(), PATH.string());
+        }
+    }
+
+    size_t count = m_mPixmaps.size();
+    for (const auto &theme : m_vChain)
+        count += theme.icons.size();
+    m_iSize = count;
+
+    m_lastCheck = Time::steadyNow();
+}
+
+void CIconThemeIndex::loadTheme(const std::string &name)
+{
+    if (std::ranges::any_of(m_vChain, [&](const STheme &t)
+                            { return t.name == name; }))
+        return;
+
+    STheme theme;
+    theme.name = name;
+
+    std::vector<std::string> inherits;
+    std::vector<std::string> dirNames;
+    bool foundIndex = false;
+    std::error_code ec;
+
+    for (const auto &root : m_vRoots)
+    {
+        const auto THEMEDIR = root + name + "/";
+
+        // a missing dir stamps as min, creating it counts as a change too
+        m_vWatched.emplace_back(THEMEDIR, std::filesystem::last_write_time(THEMEDIR, ec));
+        if (!std::filesystem::is_directory(THEMEDIR, ec))
+            continue;
+
+        // the first index.theme found describes the theme, the dirs may be spread over all roots
+        if (foundIndex)
+            continue;
+
+        std::ifstream file(THEMEDIR + "index.theme");
+        if (!file.is_open())
+            continue;
+
+        foundIndex = true;
+
+        std::unordered_map<std::string, SIconDir> sections;
+        std::string section;
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            line = trim(line);
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            if (line[0] == '[')
+            {
+                section = line.substr(1, line.find(']') - 1);
+                continue;
+            }
+
+            const auto EQ = line.find('=');
+            if (EQ == std::string::npos)
+                continue;
+
+            const auto KEY = trim(line.substr(0, EQ));
+            const auto VALUE = trim(line.substr(EQ + 1));
+
+            if (section == "Icon Theme")
+            {
+                if (KEY == "Inherits")
+                    inherits = splitList(VALUE);
+                else if (KEY == "Directories" || KEY == "ScaledDirectories")
+                {
+                    for (auto &d : splitList(VALUE))
+                        dirNames.push_back(d);
+                }
+                continue;
+            }
+
+            auto &dir = sections[section];
+            if (KEY == "Size")
+                dir.size = toInt(VALUE, 0);
+            else if (KEY == "MinSize")
+                dir.minSize = toInt(VALUE, 0);
+            else if (KEY == "MaxSize")
+                dir.maxSize = toInt(VALUE, 0);
+            else if (KEY == "Threshold")
+                dir.threshold = toInt(VALUE, 2);
+            else if (KEY == "Scale")
+                dir.scale = toInt(VALUE, 1);
+            else if (KEY == "Type")
+                dir.type = VALUE == "Fixed" ? DIR_FIXED : VALUE == "Scalable" ? DIR_SCALABLE : DIR_THRESHOLD;
+        }
+
+        for (const auto &d : dirNames)
+        {
+            auto dir = sections[d];
+            // unset min/max default to the nominal size
+            if (!dir.minSize)
+                dir.minSize = dir.size;
+            if (!dir.maxSize)
+                dir.maxSize = dir.size;
+            theme.dirs.push_back(dir);
+        }
+    }
+
+    if (!foundIndex)
+        return;
+
+    // now list every dir of the theme, in every root that has it
+    for (size_t i = 0; i < dirNames.size(); ++i)
+    {
+        for (const auto &root : m_vRoots)
+        {
+            // icons copied into an existing size dir only change that dir's mtime
+            const auto SIZEDIR = root + name + "/" + dirNames[i];
+            m_vWatched.emplace_back(SIZEDIR, std::filesystem::last_write_time(SIZEDIR, ec));
+
+            for (const auto &file : std::filesystem::directory_iterator(SIZEDIR, ec))
+            {
+                const auto PATH = file.path();
+                if (PATH.extension() == ".png")
+                    theme.icons[PATH.stem().string()].push_back(SIcon{i, PATH.string()});
+            }
+        }
+    }
+
+    m_vChain.push_back(std::move(theme));
+
+    for (const auto &parent : inherits)
+        loadTheme(parent);
+}
+
+bool CIconThemeIndex::matchesSize(const SIconDir &dir, int size)
+{
+    switch (dir.type)
+    {
+    case DIR_FIXED:
+        return dir.size * dir.scale == size;
+    case DIR_SCALABLE:
+        return dir.minSize * dir.scale <= size && size <= dir.maxSize * dir.scale;
+    case DIR_THRESHOLD:
+        return (dir.size - dir.threshold) * dir.scale <= size && size <= (dir.size + dir.threshold) * dir.scale;
+    }
+
+    return false;
+}
+
+int CIconThemeIndex::sizeDistance(const SIconDir &dir, int size)
+{
+    int min = dir.size, max = dir.size;
+    if (dir.type == DIR_SCALABLE)
+    {
+        min = dir.minSize;
+        max = dir.maxSize;
+    }
+    else if (dir.type == DIR_THRESHOLD)
+    {
+        min = dir.size - dir.threshold;
+        max = dir.size + dir.threshold;
+    }
+
+    if (size < min * dir.scale)
+        return min * dir.scale - size;
+    if (size > max * dir.scale)
+        return size - max * dir.scale;
+    return 0;
+}
+
+void CIconThemeIndex::ensureBuilt()
+{
+    // a theme set while building gets a new generation and another build
+    const uint64_t GENERATION = m_iGeneration;
+    if (GENERATION == m_iBuiltGeneration && !stale())
+        return;
+
+    {
+        std::lock_guard pending(m_pendingMutex);
+        m_szTheme = m_szPendingTheme;
+    }
+
+    build();
+    m_iBuiltGeneration = GENERATION;
+
+    if (m_iBuilds > 1)
+        m_iChanges++;
+}
+
+void CIconThemeIndex::refresh()
+{
+    std::lock_guard lock(m_mutex);
+    ensureBuilt();
+}
+
+std::string CIconThemeIndex::lookup(const std::string &name, int size)
+{
+    std::lock_guard lock(m_mutex);
+
+    ensureBuilt();
+
+    m_iLookups++;
+
+    for (const auto &theme : m_vChain)
+    {
+        const auto IT = theme.icons.find(name);
+        if (IT == theme.icons.end())
+            continue;
+
+        const SIcon *best = nullptr;
+        int bestDistance = INT_MAX;
+        int bestSize = 0;
+
+        for (const auto &icon : IT->second)
+        {
+            const auto &DIR = theme.dirs[icon.dir];
+            if (matchesSize(DIR, size))
+                return icon.path;
+
+            // prefer scaling down over scaling up when equally far off
+            const int DISTANCE = sizeDistance(DIR, size);
+            const int DIRSIZE = DIR.size * DIR.scale;
+            if (DISTANCE < bestDistance || (DISTANCE == bestDistance && DIRSIZE > bestSize))
+            {
+                best = &icon;
+                bestDistance = DISTANCE;
+                bestSize = DIRSIZE;
+            }
+        }
+
+        if (best)
+            return best->path;
+    }
+
+    const auto PIXMAP = m_mPixmaps.find(name);
+    if (PIXMAP != m_mPixmaps.end())
+        return PIXMAP->second;
+
+    m_iMisses++;
+    return "";
+}
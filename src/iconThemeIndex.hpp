@@ -0,0 +1,102 @@
+#pragma once
+
+#include <hyprland/src/helpers/time/Time.hpp>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Icon themes read from their index.theme, with inheritance, indexed by icon
+// name. Only png icons are indexed since that is all we can load. Lookups and
+// builds happen on the icon loader thread, the main thread only hands over
+// changes and never waits for a build.
+class CIconThemeIndex
+{
+public:
+    // empty keeps the built-in list of common themes, applied on the next lookup
+    void setTheme(const std::string &theme);
+
+    // best png for name at size pixels, or empty
+    std::string lookup(const std::string &name, int size);
+
+    // rebuilds now if the theme changed or the dirs look stale, without looking anything up
+    void refresh();
+
+    // rebuilt on the next lookup
+    void invalidate();
+
+    std::atomic<size_t> m_iBuilds = 0;
+    std::atomic<size_t> m_iLookups = 0;
+    std::atomic<size_t> m_iMisses = 0;
+    // bumped by every build after the first, answers from before may be stale
+    std::atomic<uint64_t> m_iChanges = 0;
+
+    size_t size() const;
+
+private:
+    enum eDirType : uint8_t
+    {
+        DIR_THRESHOLD = 0,
+        DIR_FIXED,
+        DIR_SCALABLE,
+    };
+
+    struct SIconDir
+    {
+        eDirType type = DIR_THRESHOLD;
+        int size = 0;
+        int minSize = 0;
+        int maxSize = 0;
+        int threshold = 2;
+        int scale = 1;
+    };
+
+    struct SIcon
+    {
+        // index into STheme::dirs
+        size_t dir = 0;
+        std::string path;
+    };
+
+    struct STheme
+    {
+        std::string name;
+        std::vector<SIconDir> dirs;
+        std::unordered_map<std::string, std::vector<SIcon>> icons;
+    };
+
+    // called with m_mutex held
+    void ensureBuilt();
+    void build();
+    // appends the theme and whatever it inherits, unless already in the chain
+    void loadTheme(const std::string &name);
+    bool stale();
+
+    static bool matchesSize(const SIconDir &dir, int size);
+    static int sizeDistance(const SIconDir &dir, int size);
+
+    // serializes lookups, only ever taken off the main thread
+    std::mutex m_mutex;
+
+    // set from the main thread, any change bumps the generation
+    std::mutex m_pendingMutex;
+    std::string m_szPendingTheme;
+    std::atomic<uint64_t> m_iGeneration = 1;
+
+    std::string m_szTheme;
+    uint64_t m_iBuiltGeneration = 0;
+    std::atomic<size_t> m_iSize = 0;
+
+    // icon dirs, most important first
+    std::vector<std::string> m_vRoots;
+    std::vector<STheme> m_vChain;
+    // unthemed fallback icons
+    std::unordered_map<std::string, std::string> m_mPixmaps;
+
+    // theme and size dirs with their mtime when indexed, icon installs touch these
+    std::vector<std::pair<std::string, std::filesystem::file_time_type>> m_vWatched;
+    Time::steady_tp m_lastCheck;
+};
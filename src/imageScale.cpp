@@ -0,0 +1,231 @@
+#include "imageScale.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+size_t SMipChain::bytes() const
+{
+    size_t total = 0;
+    for (const auto &level : levels)
+        total += level.pixels.size() * sizeof(uint32_t);
+    return total;
+}
+
+cairo_surface_t *surfaceFromImage(const SImage &image, int x, int y, int width, int height)
+{
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+    {
+        cairo_surface_destroy(surface);
+        return nullptr;
+    }
+
+    cairo_surface_flush(surface);
+    const auto DATA = cairo_image_surface_get_data(surface);
+    const int STRIDE = cairo_image_surface_get_stride(surface);
+
+    for (int row = 0; row < height; ++row)
+        std::memcpy(DATA + (size_t)row * STRIDE, &image.pixels[(size_t)(y + row) * image.width + x], (size_t)width * 4);
+
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+static uint32_t average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        const uint32_t SUM = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+        result |= ((SUM + 2) >> 2) << shift;
+    }
+    return result;
+}
+
+// 2x2 box filter, odd sizes round up and their edge pixel repeats the last row/column
+static SImage halve(const SImage &src)
+{
+    SImage dst;
+    dst.width = (src.width + 1) / 2;
+    dst.height = (src.height + 1) / 2;
+    dst.pixels.resize((size_t)dst.width * dst.height);
+
+    for (int y = 0; y < dst.height; ++y)
+    {
+        const uint32_t *row0 = &src.pixels[(size_t)std::min(y * 2, src.height - 1) * src.width];
+        const uint32_t *row1 = &src.pixels[(size_t)std::min(y * 2 + 1, src.height - 1) * src.width];
+        uint32_t *out = &dst.pixels[(size_t)y * dst.width];
+
+        int x = 0;
+
+#if defined(__SSE2__)
+        // four source pixels of each row make two output pixels
+        if (src.width >= 2)
+        {
+            const __m128i ZERO = _mm_setzero_si128();
+            const __m128i ROUND = _mm_set1_epi16(2);
+
+            for (; x + 2 <= dst.width && x * 2 + 4 <= src.width; x += 2)
+            {
+                const __m128i A = _mm_loadu_si128((const __m128i *)(row0 + x * 2));
+                const __m128i B = _mm_loadu_si128((const __m128i *)(row1 + x * 2));
+
+                // per channel sums of the two rows, pixels 0,1 and 2,3
+                const __m128i LO = _mm_add_epi16(_mm_unpacklo_epi8(A, ZERO), _mm_unpacklo_epi8(B, ZERO));
+                const __m128i HI = _mm_add_epi16(_mm_unpackhi_epi8(A, ZERO), _mm_unpackhi_epi8(B, ZERO));
+
+                // then horizontally, 0+1 and 2+3
+                __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(LO, HI), _mm_unpackhi_epi64(LO, HI));
+                sum = _mm_srli_epi16(_mm_add_epi16(sum, ROUND), 2);
+
+                _mm_storel_epi64((__m128i *)(out + x), _mm_packus_epi16(sum, ZERO));
+            }
+        }
+#endif
+
+        for (; x < dst.width; ++x)
+        {
+            const int X0 = std::min(x * 2, src.width - 1);
+            const int X1 = std::min(x * 2 + 1, src.width - 1);
+            out[x] = average4(row0[X0], row0[X1], row1[X0], row1[X1]);
+        }
+    }
+
+    return dst;
+}
+
+SMipChain buildMipChain(SImage source, int minSize)
+{
+    SMipChain chain;
+    chain.levels.push_back(std::move(source));
+
+    while (std::min(chain.levels.back().width, chain.levels.back().height) / 2 >= std::max(minSize, 1))
+        chain.levels.push_back(halve(chain.levels.back()));
+
+    return chain;
+}
+
+struct STap
+{
+    int index = 0;
+    float weight = 0;
+};
+
+// per destination pixel, the source pixels it reads and how much of each
+static std::vector<std::vector<STap>> taps(int src, int dst)
+{
+    std::vector<std::vector<STap>> result(dst);
+    const float SCALE = (float)src / dst;
+
+    for (int d = 0; d < dst; ++d)
+    {
+        if (SCALE <= 1.F)
+        {
+            const float CENTER = std::clamp((d + 0.5F) * SCALE - 0.5F, 0.F, (float)(src - 1));
+            const int S0 = (int)CENTER;
+            const float F = CENTER - S0;
+            result[d].push_back({S0, 1.F - F});
+            if (F > 0.F)
+                result[d].push_back({std::min(S0 + 1, src - 1), F});
+            continue;
+        }
+
+        const float START = d * SCALE;
+        const float END = (d + 1) * SCALE;
+        for (int s = (int)START; s < (int)std::ceil(END); ++s)
+        {
+            const float COVERAGE = std::min(END, s + 1.F) - std::max(START, (float)s);
+            if (COVERAGE > 0.F)
+                result[d].push_back({std::min(s, src - 1), COVERAGE / SCALE});
+        }
+    }
+
+    return result;
+}
+
+cairo_surface_t *scaleFromMipChain(const SMipChain &chain, int size)
+{
+    if (chain.levels.empty() || size <= 0)
+        return nullptr;
+
+    const auto &BASE = chain.levels.front();
+    const float FIT = (float)size / std::max(BASE.width, BASE.height);
+    const int DSTW = std::max(1, (int)std::lround(BASE.width * FIT));
+    const int DSTH = std::max(1, (int)std::lround(BASE.height * FIT));
+
+    // smallest level still covering the target, at most 2x larger
+    const SImage *level = &BASE;
+    for (const auto &l : chain.levels)
+    {
+        if (l.width < DSTW || l.height < DSTH)
+            break;
+        level = &l;
+    }
+
+    const auto XTAPS = taps(level->width, DSTW);
+    const auto YTAPS = taps(level->height, DSTH);
+
+    // horizontal pass into floats, the vertical pass writes the surface
+    std::vector<float> rows((size_t)level->height * DSTW * 4);
+    for (int y = 0; y < level->height; ++y)
+    {
+        const uint32_t *in = &level->pixels[(size_t)y * level->width];
+        float *out = &rows[(size_t)y * DSTW * 4];
+
+        for (int x = 0; x < DSTW; ++x)
+        {
+            float acc[4] = {};
+            for (const auto &tap : XTAPS[x])
+            {
+                const uint32_t PX = in[tap.index];
+                for (int c = 0; c < 4; ++c)
+                    acc[c] += ((PX >> (c * 8)) & 0xff) * tap.weight;
+            }
+            std::memcpy(out + x * 4, acc, sizeof(acc));
+        }
+    }
+
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size, size);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+    {
+        cairo_surface_destroy(surface);
+        return nullptr;
+    }
+
+    cairo_surface_flush(surface);
+    const auto DATA = cairo_image_surface_get_data(surface);
+    const int STRIDE = cairo_image_surface_get_stride(surface);
+    std::memset(DATA, 0, (size_t)STRIDE * size);
+
+    const int OFFX = (size - DSTW) / 2;
+    const int OFFY = (size - DSTH) / 2;
+
+    for (int y = 0; y < DSTH; ++y)
+    {
+        uint32_t *out = (uint32_t *)(DATA + (size_t)(y + OFFY) * STRIDE) + OFFX;
+
+        for (int x = 0; x < DSTW; ++x)
+        {
+            float acc[4] = {};
+            for (const auto &tap : YTAPS[y])
+            {
+                const float *in = &rows[((size_t)tap.index * DSTW + x) * 4];
+                for (int c = 0; c < 4; ++c)
+                    acc[c] += in[c] * tap.weight;
+            }
+
+            uint32_t px = 0;
+            for (int c = 0; c < 4; ++c)
+                px |= (uint32_t)std::clamp((int)std::lround(acc[c]), 0, 255) << (c * 8);
+            out[x] = px;
+        }
+    }
+
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cairo/cairo.h>
+#include <cstdint>
+#include <vector>
+
+// Premultiplied ARGB32, tightly packed.
+struct SImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels;
+};
+
+// Successive 2x2 box reductions of a source image, the source itself first.
+// Built once per icon, every target size is then served from the nearest level.
+struct SMipChain
+{
+    std::vector<SImage> levels;
+
+    size_t bytes() const;
+};
+
+// an ARGB32 copy of a rect of the image, null if cairo can't allocate it
+cairo_surface_t *surfaceFromImage(const SImage &image, int x, int y, int width, int height);
+
+inline cairo_surface_t *surfaceFromImage(const SImage &image)
+{
+    return surfaceFromImage(image, 0, 0, image.width, image.height);
+}
+
+// levels stop once the next one would be smaller than minSize on its shorter side
+SMipChain buildMipChain(SImage source, int minSize);
+
+// Scales to fit size x size, centered, from the smallest level that is still at
+// least as large. Shrinking averages the covered area, growing is bilinear.
+cairo_surface_t *scaleFromMipChain(const SMipChain &chain, int size);
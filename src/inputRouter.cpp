@@ -0,0 +1,224 @@
+#include "inputRouter.hpp"
+
+#include <hyprland/src/Compositor.hpp>
+#include <hyprland/src/desktop/state/FocusState.hpp>
+#include <hyprland/src/managers/input/InputManager.hpp>
+#include <hyprland/src/protocols/LayerShell.hpp>
+#include <cmath>
+
+#include "hyprWindowDecorator.hpp"
+
+CInputRouter::CInputRouter(HANDLE handle)
+{
+    // button events
+    m_pMouseButtonCallback = HyprlandAPI::registerCallbackDynamic(
+        handle, "mouseButton", [this](void *self, SCallbackInfo &info, std::any param)
+        { onMouseButton(info, std::any_cast<IPointer::SButtonEvent>(param)); });
+    m_pTouchDownCallback = HyprlandAPI::registerCallbackDynamic(
+        handle, "touchDown", [this](void *self, SCallbackInfo &info, std::any param)
+        { onTouchDown(info, std::any_cast<ITouch::SDownEvent>(param)); });
+    m_pTouchUpCallback = HyprlandAPI::registerCallbackDynamic( //
+        handle, "touchUp", [this](void *self, SCallbackInfo &info, std::any param)
+        { onTouchUp(info, std::any_cast<ITouch::SUpEvent>(param)); });
+
+    // move events
+    m_pTouchMoveCallback = HyprlandAPI::registerCallbackDynamic(
+        handle, "touchMove", [this](void *self, SCallbackInfo &info, std::any param)
+        { onTouchMove(info, std::any_cast<ITouch::SMotionEvent>(param)); });
+    m_pMouseMoveCallback = HyprlandAPI::registerCallbackDynamic( //
+        handle, "mouseMove", [this](void *self, SCallbackInfo &info, std::any param)
+        { onMouseMove(std::any_cast<Vector2D>(param)); });
+}
+
+uint64_t CInputRouter::cellKey(int x, int y)
+{
+    return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
+
+void CInputRouter::forEachCell(const CBox &box, const std::function<void(uint64_t)> &fn)
+{
+    const int X0 = (int)std::floor(box.x / INPUT_GRID_CELL);
+    const int Y0 = (int)std::floor(box.y / INPUT_GRID_CELL);
+    const int X1 = (int)std::floor((box.x + box.w) / INPUT_GRID_CELL);
+    const int Y1 = (int)std::floor((box.y + box.h) / INPUT_GRID_CELL);
+
+    for (int x = X0; x <= X1; ++x)
+    {
+        for (int y = Y0; y <= Y1; ++y)
+            fn(cellKey(x, y));
+    }
+}
+
+void CInputRouter::updateBox(CHyprWindowDecorator *deco, const CBox &box)
+{
+    auto it = m_mBoxes.find(deco);
+    if (it != m_mBoxes.end())
+    {
+        if (it->second == box)
+            return;
+
+        forEachCell(it->second, [&](uint64_t key)
+                    { std::erase(m_mGrid[key], deco); });
+        it->second = box;
+    }
+    else
+        m_mBoxes.emplace(deco, box);
+
+    forEachCell(box, [&](uint64_t key)
+                { m_mGrid[key].push_back(deco); });
+}
+
+void CInputRouter::remove(CHyprWindowDecorator *deco)
+{
+    auto it = m_mBoxes.find(deco);
+    if (it != m_mBoxes.end())
+    {
+        forEachCell(it->second, [&](uint64_t key)
+                    { std::erase(m_mGrid[key], deco); });
+        m_mBoxes.erase(it);
+    }
+
+    std::erase(m_vGrabs, deco);
+    std::erase(m_vCandidates, deco);
+    std::erase(m_vHovered, deco);
+}
+
+const SInputContext &CInputRouter::context()
+{
+    if (m_context.serial == m_iSerial)
+        return m_context;
+
+    m_iContextBuilds++;
+
+    m_context.serial = m_iSerial;
+    m_context.mouseCoords = g_pInputManager->getMouseCoordsInternal();
+    m_context.exclusiveLS = !g_pInputManager->m_exclusiveLSes.empty();
+    m_context.windowAtCursor = g_pCompositor->vectorToWindowUnified(m_context.mouseCoords, Desktop::View::RESERVED_EXTENTS | Desktop::View::INPUT_EXTENTS | Desktop::View::ALLOW_FLOATING);
+
+    // check if input is on top or overlay shell layers
+    const auto PMONITOR = Desktop::focusState()->monitor();
+    PHLLS foundSurface = nullptr;
+    Vector2D surfaceCoords;
+
+    if (PMONITOR)
+    {
+        g_pCompositor->vectorToLayerSurface(m_context.mouseCoords, &PMONITOR->m_layerSurfaceLayers[ZWLR_LAYER_SHELL_V1_LAYER_TOP], &surfaceCoords, &foundSurface);
+
+        if (!foundSurface)
+            g_pCompositor->vectorToLayerSurface(m_context.mouseCoords, &PMONITOR->m_layerSurfaceLayers[ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY], &surfaceCoords, &foundSurface);
+    }
+
+    m_context.onLayerSurface = foundSurface != nullptr;
+
+    return m_context;
+}
+
+void CInputRouter::collect(const std::optional<Vector2D> &pos, bool withHovered)
+{
+    m_iEvents++;
+    // new event, whatever context was built for the previous one is stale
+    m_iSerial++;
+
+    m_vCandidates = m_vGrabs;
+
+    if (withHovered)
+    {
+        for (auto deco : m_vHovered)
+        {
+            if (std::ranges::find(m_vCandidates, deco) == m_vCandidates.end())
+                m_vCandidates.push_back(deco);
+        }
+    }
+
+    if (pos)
+    {
+        const auto CELL = m_mGrid.find(cellKey((int)std::floor(pos->x / INPUT_GRID_CELL), (int)std::floor(pos->y / INPUT_GRID_CELL)));
+        if (CELL != m_mGrid.end())
+        {
+            for (auto deco : CELL->second)
+            {
+                if (m_mBoxes.at(deco).containsPoint(*pos) && std::ranges::find(m_vCandidates, deco) == m_vCandidates.end())
+                    m_vCandidates.push_back(deco);
+            }
+        }
+    }
+
+    m_iDispatches += m_vCandidates.size();
+}
+
+void CInputRouter::updateGrabs()
+{
+    for (auto deco : m_vCandidates)
+    {
+        const bool GRAB = deco->hasGrab();
+        const bool LISTED = std::ranges::find(m_vGrabs, deco) != m_vGrabs.end();
+
+        if (GRAB && !LISTED)
+            m_vGrabs.push_back(deco);
+        else if (!GRAB && LISTED)
+            std::erase(m_vGrabs, deco);
+    }
+}
+
+void CInputRouter::onMouseButton(SCallbackInfo &info, IPointer::SButtonEvent e)
+{
+    collect(g_pInputManager->getMouseCoordsInternal());
+
+    // index based, a handler may end up removing a decoration
+    for (size_t i = 0; i < m_vCandidates.size(); ++i)
+        m_vCandidates[i]->onMouseButton(info, e);
+
+    updateGrabs();
+}
+
+void CInputRouter::onMouseMove(Vector2D coords)
+{
+    collect(coords, true);
+
+    // every hovered decoration is a candidate, so this sees all of them
+    m_vHovered.clear();
+    for (size_t i = 0; i < m_vCandidates.size(); ++i)
+    {
+        const auto DECO = m_vCandidates[i];
+        DECO->onMouseMove(coords);
+
+        if (DECO->m_iButtonHoverState != 0)
+            m_vHovered.push_back(DECO);
+    }
+
+    updateGrabs();
+}
+
+void CInputRouter::onTouchDown(SCallbackInfo &info, ITouch::SDownEvent e)
+{
+    auto PMONITOR = g_pCompositor->getMonitorFromName(!e.device->m_boundOutput.empty() ? e.device->m_boundOutput : "");
+    PMONITOR = PMONITOR ? PMONITOR : Desktop::focusState()->monitor();
+
+    collect(PMONITOR ? std::optional<Vector2D>(PMONITOR->m_position + e.pos * PMONITOR->m_size) : std::nullopt);
+
+    for (size_t i = 0; i < m_vCandidates.size(); ++i)
+        m_vCandidates[i]->onTouchDown(info, e);
+
+    updateGrabs();
+}
+
+void CInputRouter::onTouchUp(SCallbackInfo &info, ITouch::SUpEvent e)
+{
+    // only decorations with a pending touch drag care about these
+    collect(std::nullopt);
+
+    for (size_t i = 0; i < m_vCandidates.size(); ++i)
+        m_vCandidates[i]->onTouchUp(info, e);
+
+    updateGrabs();
+}
+
+void CInputRouter::onTouchMove(SCallbackInfo &info, ITouch::SMotionEvent e)
+{
+    collect(std::nullopt);
+
+    for (size_t i = 0; i < m_vCandidates.size(); ++i)
+        m_vCandidates[i]->onTouchMove(info, e);
+
+    updateGrabs();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#define WLR_USE_UNSTABLE
+
+#include <hyprland/src/plugins/PluginAPI.hpp>
+#include <hyprland/src/desktop/DesktopTypes.hpp>
+#include <hyprland/src/devices/IPointer.hpp>
+#include <hyprland/src/devices/ITouch.hpp>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+class CHyprWindowDecorator;
+
+// Everything about an input event that doesn't depend on the decoration handling it.
+// Focus is not part of it, a handler may change focus halfway through the event.
+struct SInputContext
+{
+    uint64_t serial = 0;
+    Vector2D mouseCoords;
+    PHLWINDOWREF windowAtCursor;
+    bool exclusiveLS = false;
+    // cursor is over a top or overlay layer surface
+    bool onLayerSurface = false;
+};
+
+// Size of a spatial index cell in layout coordinates.
+constexpr int INPUT_GRID_CELL = 512;
+
+// Owns the pointer and touch hooks for all decorations. Decoration boxes are kept
+// in a grid so an event only reaches the decorations under it, the ones holding
+// a grab (drag or pressed button) and the ones still showing a hovered button.
+class CInputRouter
+{
+public:
+    CInputRouter(HANDLE handle);
+
+    // box in global layout coordinates, called whenever the decoration is drawn
+    void updateBox(CHyprWindowDecorator *deco, const CBox &box);
+    void remove(CHyprWindowDecorator *deco);
+
+    // computed once per event, on first use
+    const SInputContext &context();
+
+    size_t m_iEvents = 0;
+    size_t m_iDispatches = 0;
+    size_t m_iContextBuilds = 0;
+
+private:
+    void onMouseButton(SCallbackInfo &info, IPointer::SButtonEvent e);
+    void onMouseMove(Vector2D coords);
+    void onTouchDown(SCallbackInfo &info, ITouch::SDownEvent e);
+    void onTouchUp(SCallbackInfo &info, ITouch::SUpEvent e);
+    void onTouchMove(SCallbackInfo &info, ITouch::SMotionEvent e);
+
+    // fills m_vCandidates with the grabs, optionally the hovered decorations and whatever is under pos
+    void collect(const std::optional<Vector2D> &pos, bool withHovered = false);
+    void updateGrabs();
+
+    static uint64_t cellKey(int x, int y);
+    void forEachCell(const CBox &box, const std::function<void(uint64_t)> &fn);
+
+    std::unordered_map<uint64_t, std::vector<CHyprWindowDecorator *>> m_mGrid;
+    std::unordered_map<CHyprWindowDecorator *, CBox> m_mBoxes;
+
+    std::vector<CHyprWindowDecorator *> m_vGrabs;
+    std::vector<CHyprWindowDecorator *> m_vCandidates;
+    // overlapping bars can each have a hovered button, all of them need to see the pointer leave
+    std::vector<CHyprWindowDecorator *> m_vHovered;
+
+    uint64_t m_iSerial = 1;
+    SInputContext m_context;
+
+    SP<HOOK_CALLBACK_FN> m_pMouseButtonCallback;
+    SP<HOOK_CALLBACK_FN> m_pTouchDownCallback;
+    SP<HOOK_CALLBACK_FN> m_pTouchUpCallback;
+
+    SP<HOOK_CALLBACK_FN> m_pTouchMoveCallback;
+    SP<HOOK_CALLBACK_FN> m_pMouseMoveCallback;
+};
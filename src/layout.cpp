@@ -0,0 +1,207 @@
+#include "layout.hpp"
+#include "plugin.hpp"
+
+#include <cmath>
+
+eTitlePlacement titlePlacementFromString(const std::string &str)
+{
+    if (str == "bottom")
+        return TITLE_PLACEMENT_BOTTOM;
+    if (str == "left")
+        return TITLE_PLACEMENT_LEFT;
+    if (str == "right")
+        return TITLE_PLACEMENT_RIGHT;
+
+    return TITLE_PLACEMENT_TOP;
+}
+
+eButtonsAlignment buttonsAlignmentFromString(const std::string &str)
+{
+    return str == "left" ? BUTTONS_ALIGN_LEFT : BUTTONS_ALIGN_RIGHT;
+}
+
+// Per placement bits of the layout. margins are the decoration sizes on each side (L, T, R, B).
+template <eTitlePlacement P>
+struct SPlacementTraits;
+
+template <>
+struct SPlacementTraits<TITLE_PLACEMENT_TOP>
+{
+    static constexpr bool VERTICAL = false;
+    static constexpr int ROTATION = 0;
+
+    static CBox bar(const Vector2D &size, const double margins[4])
+    {
+        return {margins[0], 0.0, size.x - margins[0] - margins[2], margins[1]};
+    }
+};
+
+template <>
+struct SPlacementTraits<TITLE_PLACEMENT_BOTTOM>
+{
+    static constexpr bool VERTICAL = false;
+    static constexpr int ROTATION = 0;
+
+    static CBox bar(const Vector2D &size, const double margins[4])
+    {
+        return {margins[0], size.y - margins[3], size.x - margins[0] - margins[2], margins[3]};
+    }
+};
+
+template <>
+struct SPlacementTraits<TITLE_PLACEMENT_LEFT>
+{
+    static constexpr bool VERTICAL = true;
+    static constexpr int ROTATION = -1;
+
+    static CBox bar(const Vector2D &size, const double margins[4])
+    {
+        return {0.0, margins[1], margins[0], size.y - margins[1] - margins[3]};
+    }
+};
+
+template <>
+struct SPlacementTraits<TITLE_PLACEMENT_RIGHT>
+{
+    static constexpr bool VERTICAL = true;
+    static constexpr int ROTATION = 1;
+
+    static CBox bar(const Vector2D &size, const double margins[4])
+    {
+        return {size.x - margins[2], margins[1], margins[2], size.y - margins[1] - margins[3]};
+    }
+};
+
+template <eTitlePlacement P>
+void SDecorationLayout::build(const Vector2D &size, const double margins[4])
+{
+    using TRAITS = SPlacementTraits<P>;
+
+    vertical = TRAITS::VERTICAL;
+    rotation = TRAITS::ROTATION;
+    bar = TRAITS::bar(size, margins);
+
+    // everything below is laid out along/across the bar, then mapped onto it
+    const auto BAR = barAxes(bar.size(), TRAITS::VERTICAL);
+    const auto toBar = [this](const CBox &box)
+    {
+        return CBox{bar.pos() + barAxes(box.pos(), TRAITS::VERTICAL), barAxes(box.size(), TRAITS::VERTICAL)};
+    };
+
+    const bool RIGHT = alignment == BUTTONS_ALIGN_RIGHT;
+    const double PADDING = gPlugin->decoration_padding;
+    const double BUTTONPAD = gPlugin->bar_button_padding;
+    const double ICONRESERVED = gPlugin->decoration_appicon_enabled ? BAR.y : 0;
+
+    icon = {};
+    if (gPlugin->decoration_appicon_enabled)
+        icon = toBar({BAR.y * 0.2, BAR.y * 0.2, BAR.y * 0.6, BAR.y * 0.6}).translate(gPlugin->decoration_appicon_offset);
+
+    buttons.clear();
+    buttonHitboxes.clear();
+
+    double available = BAR.x - PADDING * 2 - ICONRESERVED;
+    double offset = PADDING + (RIGHT ? 0 : ICONRESERVED);
+    // the title makes room for all buttons, even the ones that don't fit
+    double buttonsSpan = BUTTONPAD;
+    bool fits = true;
+
+    for (const auto &b : gPlugin->m_vButtons)
+    {
+        const auto SIZE = barAxes(b.size, TRAITS::VERTICAL);
+        buttonsSpan += SIZE.x + BUTTONPAD;
+
+        fits = fits && available >= SIZE.x + BUTTONPAD;
+        if (!fits)
+            continue;
+
+        available -= SIZE.x + BUTTONPAD;
+
+        const double ALONG = RIGHT ? BAR.x - offset - SIZE.x : offset;
+        const double ACROSS = std::floor((BAR.y - SIZE.y) / 2.0);
+
+        buttons.push_back(toBar({ALONG, ACROSS, SIZE.x, SIZE.y}));
+        buttonHitboxes.push_back(toBar({RIGHT ? ALONG - BUTTONPAD : ALONG, ACROSS, SIZE.x + BUTTONPAD, SIZE.y}));
+
+        offset += SIZE.x + BUTTONPAD;
+    }
+
+    title = {PADDING + (RIGHT ? 0 : buttonsSpan) + ICONRESERVED, 0.0, BAR.x - PADDING * 2 - buttonsSpan - ICONRESERVED, BAR.y};
+}
+
+bool SDecorationLayout::update(const Vector2D &size, float newScale, bool focused)
+{
+    if (size == m_vSize && newScale == scale && focused == m_bFocused && m_iGeneration == gPlugin->m_iLayoutGeneration)
+        return false;
+
+    m_vSize = size;
+    scale = newScale;
+    m_bFocused = focused;
+    m_iGeneration = gPlugin->m_iLayoutGeneration;
+
+    placement = gPlugin->decoration_title_placement;
+    alignment = gPlugin->bar_buttons_alignment;
+
+    const auto P = gPlugin->decoration_padding;
+
+    // the bar follows the nine-patch of the current focus state...
+    const auto &NPI = focused ? gPlugin->activeNinepatch : gPlugin->inactiveNinepatch;
+    const double MARGINS[4] = {(double)(gPlugin->decoration_offset_left + NPI.padding[0] + P), (double)(gPlugin->decoration_offset_top + NPI.padding[1] + P),
+                               (double)(gPlugin->decoration_offset_right + NPI.padding[2] + P), (double)(gPlugin->decoration_offset_bottom + NPI.padding[3] + P)};
+
+    // ...while the reserved extents, and so the window, always use the same one
+    const auto &EXTNPI = gPlugin->activeNinepatch.defined ? gPlugin->activeNinepatch : gPlugin->inactiveNinepatch;
+    const double L = gPlugin->decoration_offset_left + EXTNPI.padding[0] + P;
+    const double T = gPlugin->decoration_offset_top + EXTNPI.padding[1] + P;
+    const double R = gPlugin->decoration_offset_right + EXTNPI.padding[2] + P;
+    const double B = gPlugin->decoration_offset_bottom + EXTNPI.padding[3] + P;
+    content = {L, T, size.x - L - R, size.y - T - B};
+
+    switch (placement)
+    {
+    case TITLE_PLACEMENT_TOP:
+        build<TITLE_PLACEMENT_TOP>(size, MARGINS);
+        break;
+    case TITLE_PLACEMENT_BOTTOM:
+        build<TITLE_PLACEMENT_BOTTOM>(size, MARGINS);
+        break;
+    case TITLE_PLACEMENT_LEFT:
+        build<TITLE_PLACEMENT_LEFT>(size, MARGINS);
+        break;
+    case TITLE_PLACEMENT_RIGHT:
+        build<TITLE_PLACEMENT_RIGHT>(size, MARGINS);
+        break;
+    }
+
+    barPx = bar.copy().scale(scale).round();
+    iconPx = icon.copy().scale(scale).round();
+
+    buttonsPx.clear();
+    for (const auto &b : buttons)
+        buttonsPx.push_back({(b.pos() * scale).round(), (b.size() * scale).round()});
+
+    return true;
+}
+
+int SDecorationLayout::buttonAt(const Vector2D &pos) const
+{
+    if (!VECINRECT(pos, bar.x, bar.y, bar.x + bar.w, bar.y + bar.h))
+        return -1;
+
+    for (size_t i = 0; i < buttonHitboxes.size(); ++i)
+    {
+        const auto &BOX = buttonHitboxes[i];
+        if (VECINRECT(pos, BOX.x, BOX.y, BOX.x + BOX.w, BOX.y + BOX.h))
+            return (int)i;
+    }
+
+    return -1;
+}
+
+bool SDecorationLayout::isOnDecoration(const Vector2D &pos) const
+{
+    if (!VECINRECT(pos, 0, 0, m_vSize.x, m_vSize.y))
+        return false;
+
+    return !(pos.x >= content.x && pos.x < content.x + content.w && pos.y >= content.y && pos.y < content.y + content.h);
+}
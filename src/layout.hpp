@@ -0,0 +1,74 @@
+#pragma once
+
+#include <hyprland/src/helpers/math/Math.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum eTitlePlacement : uint8_t
+{
+    TITLE_PLACEMENT_TOP = 0,
+    TITLE_PLACEMENT_BOTTOM,
+    TITLE_PLACEMENT_LEFT,
+    TITLE_PLACEMENT_RIGHT,
+};
+
+enum eButtonsAlignment : uint8_t
+{
+    BUTTONS_ALIGN_RIGHT = 0,
+    BUTTONS_ALIGN_LEFT,
+};
+
+eTitlePlacement titlePlacementFromString(const std::string &str);
+eButtonsAlignment buttonsAlignmentFromString(const std::string &str);
+
+// Bars on the left/right run along y. Bar layout is done along (x) and across (y) the bar,
+// this maps between that and the actual orientation, it is its own inverse.
+inline Vector2D barAxes(const Vector2D &v, bool vertical)
+{
+    return vertical ? Vector2D(v.y, v.x) : v;
+}
+
+// Where everything on a decoration goes. Logical rects are relative to the decoration
+// box, so hit testing uses them as is; pixel rects are relative to the scaled box.
+// Only recomputed when the size, scale, focus or config changes.
+struct SDecorationLayout
+{
+    eTitlePlacement placement = TITLE_PLACEMENT_TOP;
+    eButtonsAlignment alignment = BUTTONS_ALIGN_RIGHT;
+    bool vertical = false;
+    // quarter turns applied to things drawn along the bar
+    int rotation = 0;
+
+    // the hole the window sits in, everything else is decoration
+    CBox content;
+    CBox bar;
+    // slot for the app icon, empty if disabled
+    CBox icon;
+    // space left for the title, along (x) and across (y) the bar
+    CBox title;
+    // only the buttons that fit
+    std::vector<CBox> buttons;
+    // button rect plus the padding on its inner side
+    std::vector<CBox> buttonHitboxes;
+
+    CBox barPx;
+    CBox iconPx;
+    std::vector<CBox> buttonsPx;
+
+    float scale = 1.f;
+
+    // returns true if the layout changed
+    bool update(const Vector2D &size, float scale, bool focused);
+
+    int buttonAt(const Vector2D &pos) const;
+    bool isOnDecoration(const Vector2D &pos) const;
+
+private:
+    template <eTitlePlacement P>
+    void build(const Vector2D &size, const double margins[4]);
+
+    Vector2D m_vSize;
+    bool m_bFocused = false;
+    uint64_t m_iGeneration = 0;
+};
@@ -27,15 +27,18 @@ static void onNewWindow(void *self, std::any data)
 
     if (!PWINDOW->m_X11DoesntWantBorders)
     {
-        if (std::ranges::any_of(PWINDOW->m_windowDecorations, [](const auto &d)
-                                { return d->getDisplayName() == "Hyprdecor"; }))
+        if (gPlugin->barForWindow(PWINDOW))
             return;
 
         auto bar = makeUnique<CHyprWindowDecorator>(PWINDOW);
         auto barRaw = bar.get();
         barRaw->m_self = barRaw;
         gPlugin->m_vBars.push_back(barRaw);
+        gPlugin->m_mBarsByWindow[PWINDOW] = barRaw;
         HyprlandAPI::addWindowDecoration(gPlugin->m_pHandle, PWINDOW, std::move(bar));
+
+        // windows opened on a hidden workspace stay without textures until warmed up
+        gPlugin->scheduleWarmUp();
     }
 }
 
@@ -44,34 +47,29 @@ static void onCloseWindow(void *self, std::any data)
     // data is guaranteed
     const auto PWINDOW = std::any_cast<PHLWINDOW>(data);
 
-    const auto BARIT = std::find_if(gPlugin->m_vBars.begin(), gPlugin->m_vBars.end(), [PWINDOW](const auto &bar)
-                                    { return bar && bar->getOwner() == PWINDOW; });
-
-    if (BARIT == gPlugin->m_vBars.end())
+    const auto BAR = gPlugin->barForWindow(PWINDOW);
+    if (!BAR)
         return;
 
     // we could use the API but this is faster + it doesn't matter here that much.
-    PWINDOW->removeWindowDeco(*BARIT);
+    // destroys the bar right away, which drops its textures and index entries
+    PWINDOW->removeWindowDeco(BAR);
 }
 
 static void onPreConfigReload()
 {
     gPlugin->m_vButtons.clear();
+    gPlugin->m_iLayoutGeneration++;
 }
 
 static void onUpdateWindowRules(PHLWINDOW window)
 {
-    const auto BARIT = std::find_if(gPlugin->m_vBars.begin(), gPlugin->m_vBars.end(), [window](CHyprWindowDecorator *bar)
-                                    { return bar && bar->getOwner() == window; });
-
-    if (BARIT == gPlugin->m_vBars.end())
+    const auto BAR = gPlugin->barForWindow(window);
+    if (!BAR)
         return;
 
-    if (*BARIT)
-    {
-        (*BARIT)->updateRules();
-        window->updateWindowDecos();
-    }
+    BAR->updateRules();
+    window->updateWindowDecos();
 }
 
 APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle)
@@ -94,7 +92,8 @@ APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle)
 
     static auto P = HyprlandAPI::registerCallbackDynamic(gPlugin->m_pHandle, "openWindow", [&](void *self, SCallbackInfo &info, std::any data)
                                                          { onNewWindow(self, data); });
-    // static auto P2 = HyprlandAPI::registerCallbackDynamic(g_pConfig->m_pHandle, "closeWindow", [&](void* self, SCallbackInfo& info, std::any data) { onCloseWindow(self, data); });
+    static auto P2 = HyprlandAPI::registerCallbackDynamic(gPlugin->m_pHandle, "closeWindow", [&](void *self, SCallbackInfo &info, std::any data)
+                                                          { onCloseWindow(self, data); });
     static auto P3 = HyprlandAPI::registerCallbackDynamic(gPlugin->m_pHandle, "windowUpdateRules",
                                                           [&](void *self, SCallbackInfo &info, std::any data)
                                                           { onUpdateWindowRules(std::any_cast<PHLWINDOW>(data)); });
@@ -104,6 +103,12 @@ APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle)
     static auto P5 = HyprlandAPI::registerCallbackDynamic(gPlugin->m_pHandle, "configReloaded", [&](void *self, SCallbackInfo &info, std::any data)
                                                           { gPlugin->update(); });
 
+    static auto P6 = HyprlandAPI::registerCallbackDynamic(gPlugin->m_pHandle, "workspace", [&](void *self, SCallbackInfo &info, std::any data)
+                                                          { gPlugin->onWorkspaceShown(std::any_cast<PHLWORKSPACE>(data)); });
+
+    static auto PSTATS = HyprlandAPI::registerHyprCtlCommand(gPlugin->m_pHandle, SHyprCtlCommand{.name = "hyprdecorstats", .exact = true, .fn = [](eHyprCtlOutputFormat format, std::string request)
+                                                                                                 { return gPlugin->getStats(); }});
+
     // add deco to existing windows
     for (auto &w : g_pCompositor->m_windows)
     {
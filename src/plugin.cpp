@@ -2,8 +2,16 @@
 #include "hyprWindowDecorator.hpp"
 #include "util.hpp"
 #include <hyprland/src/config/ConfigManager.hpp>
+#include <hyprland/src/managers/eventLoop/EventLoopManager.hpp>
 #include <filesystem>
 
+// bars drawn more recently than this are taken to be on screen
+constexpr auto TEXTURE_EVICT_MIN_UNSEEN = std::chrono::seconds(1);
+// with low_memory, nine-patch surfaces are kept this long after their last use so a burst of bar rasters decodes once
+constexpr auto LOW_MEMORY_RELEASE_DELAY = std::chrono::seconds(1);
+// at most one hidden bar is rasterized per interval, and none while visible bars are rasterizing
+constexpr auto WARMUP_INTERVAL = std::chrono::milliseconds(50);
+
 static std::string resolveTexturePath(const std::string &base, const std::vector<std::string> &suffixes, const std::string &fallback = "")
 {
     for (const auto &suffix : suffixes)
@@ -15,6 +23,11 @@ static std::string resolveTexturePath(const std::string &base, const std::vector
     return fallback;
 }
 
+static size_t surfaceBytes(cairo_surface_t *surface)
+{
+    return surface ? (size_t)cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface) : 0;
+}
+
 Hyprlang::CParseResult onNewButtonTextured(const char *K, const char *V)
 {
     std::string v = V;
@@ -44,6 +57,7 @@ Hyprlang::CParseResult onNewButtonTextured(const char *K, const char *V)
     SHyprButton button;
     button.size = {size, size};
     button.cmd = vars[1];
+    button.action = parseButtonAction(button.cmd);
 
     if (vars.size() == 3)
     {
@@ -62,6 +76,7 @@ Hyprlang::CParseResult onNewButtonTextured(const char *K, const char *V)
     }
 
     gPlugin->m_vButtons.push_back(button);
+    gPlugin->m_iLayoutGeneration++;
 
     for (auto bar : gPlugin->m_vBars)
     {
@@ -81,7 +96,10 @@ void CPlugin::loadAllTextures()
         {
             loadTexture(button.pathActive, button.texActive, ninepatch_linear_filtering);
             if (button.size.x <= 0 && button.texActive->m_texID != 0)
+            {
                 button.size = button.texActive->m_size;
+                m_iLayoutGeneration++;
+            }
         }
         if (!button.pathInactive.empty() && button.texInactive->m_texID == 0)
             loadTexture(button.pathInactive, button.texInactive, ninepatch_linear_filtering);
@@ -91,7 +109,10 @@ void CPlugin::loadAllTextures()
             loadTexture(button.pathPressed, button.texPressed, ninepatch_linear_filtering);
 
         if (button.size.x <= 0)
+        {
             button.size = {20, 20};
+            m_iLayoutGeneration++;
+        }
     }
 }
 
@@ -114,6 +135,9 @@ CPlugin::CPlugin(HANDLE handle)
     HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:bar_button_padding", Hyprlang::INT{5});
     HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:enabled", Hyprlang::INT{1});
     HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:on_double_click", Hyprlang::STRING{""});
+    HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:title_update_interval", Hyprlang::INT{50});
+    HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:title_update_interval_unfocused", Hyprlang::INT{250});
+    HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:resize_settle_ms", Hyprlang::INT{150});
 
     HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:ninepatch_texture", Hyprlang::STRING{""});
     HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:ninepatch_active", Hyprlang::STRING{""});
@@ -129,16 +153,288 @@ CPlugin::CPlugin(HANDLE handle)
     HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:decoration_appicon_enabled", Hyprlang::INT{1});
     HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:decoration_render_above", Hyprlang::INT{0});
     HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:decoration_appicon_offset", Hyprlang::VEC2{0, 0});
+    HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:icon_theme", Hyprlang::STRING{""});
+    HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:image_max_size", Hyprlang::INT{1024});
+    HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:image_max_decode_mb", Hyprlang::INT{64});
+    HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:texture_budget_mb", Hyprlang::INT{256});
+    HyprlandAPI::addConfigValue(m_pHandle, "plugin:hyprdecor:low_memory", Hyprlang::INT{0});
 
     HyprlandAPI::addConfigKeyword(m_pHandle, "plugin:hyprdecor:hyprdecor-button", onNewButtonTextured, Hyprlang::SHandlerOptions{});
+
+    m_pInputRouter = std::make_unique<CInputRouter>(handle);
+    m_pDragEngine = std::make_unique<CDragEngine>(handle);
+    m_pIconLoader = std::make_unique<CIconLoader>(m_desktopIndex, m_iconThemes, m_iconTextures);
+
+    m_pSurfaceReleaseTimer = makeShared<CEventLoopTimer>(std::nullopt, [this](SP<CEventLoopTimer> self, void *data)
+                                                         { releaseNinePatchSurfaces(); }, nullptr);
+    g_pEventLoopManager->addTimer(m_pSurfaceReleaseTimer);
+
+    m_pWarmUpTimer = makeShared<CEventLoopTimer>(std::nullopt, [this](SP<CEventLoopTimer> self, void *data)
+                                                 { warmUpNext(); }, nullptr);
+    g_pEventLoopManager->addTimer(m_pWarmUpTimer);
+}
+
+std::string CPlugin::getStats()
+{
+    const auto &L = m_titleLayouts;
+    const size_t LOOKUPS = L.m_iHits + L.m_iMisses;
+
+    std::string result = "title layouts:\n";
+    result += std::format("\tentries: {}\n\thits: {}\n\tmisses: {}\n\thit rate: {:.1f}%\n\tevictions: {}\n\ttruncated: {}\n", L.size(), L.m_iHits, L.m_iMisses,
+                          LOOKUPS ? 100.0 * L.m_iHits / LOOKUPS : 0.0, L.m_iEvictions, L.m_iTruncations);
+
+    const auto &T = m_titleTextures;
+    const size_t TEXLOOKUPS = T.m_iHits + T.m_iMisses;
+    result += "title textures:\n";
+    result += std::format("\tentries: {}\n\thits: {}\n\tmisses: {}\n\thit rate: {:.1f}%\n\tevictions: {}\n", T.size(), T.m_iHits, T.m_iMisses,
+                          TEXLOOKUPS ? 100.0 * T.m_iHits / TEXLOOKUPS : 0.0, T.m_iEvictions);
+
+    result += std::format("input:\n\tevents: {}\n\tdispatches: {}\n\tcontext builds: {}\n", m_pInputRouter->m_iEvents, m_pInputRouter->m_iDispatches,
+                          m_pInputRouter->m_iContextBuilds);
+
+    const auto &D = m_desktopIndex;
+    result += std::format("desktop files:\n\tentries: {}\n\tscans: {}\n\trefreshes: {}\n\tlookups: {}\n", D.size(), D.m_iScans.load(), D.m_iRefreshes.load(), D.m_iLookups.load());
+
+    const auto &IT = m_iconTextures;
+    const size_t ICONLOOKUPS = IT.m_iHits + IT.m_iMisses;
+    result += std::format("icon textures:\n\tentries: {}\n\thits: {}\n\tmisses: {}\n\thit rate: {:.1f}%\n\tevictions: {}\n", IT.size(), IT.m_iHits, IT.m_iMisses,
+                          ICONLOOKUPS ? 100.0 * IT.m_iHits / ICONLOOKUPS : 0.0, IT.m_iEvictions);
+
+    const auto &IL = *m_pIconLoader;
+    result += std::format("icon loader:\n\tjobs: {}\n\tcompleted: {}\n\tdiscarded: {}\n\tpending: {}\n\tmip chains built: {}\n\tmip chain hits: {}\n", IL.m_iJobs,
+                          IL.m_iCompletions, IL.m_iDiscarded, IL.pending(), IL.m_iMipBuilds.load(), IL.m_iMipHits.load());
+
+    const auto &DC = IL.diskCache();
+    result += std::format("icon disk cache:\n\tvalid: {}\n\tloaded: {}\n\tentries: {}\n\thits: {}\n\tmisses: {}\n\twrites: {}\n", DC.m_bValid, DC.m_iLoaded, DC.size(), DC.m_iHits,
+                          DC.m_iMisses, DC.m_iWrites);
+
+    const auto &I = m_iconThemes;
+    result += std::format("icon themes:\n\ticons: {}\n\tbuilds: {}\n\tlookups: {}\n\tmisses: {}\n", I.size(), I.m_iBuilds.load(), I.m_iLookups.load(), I.m_iMisses.load());
+
+    result += std::format("oversized images:\n\treduced: {}\n\trejected: {}\n", m_iImagesReduced + IL.m_iReduced, m_iImagesRejected + IL.m_iRejected);
+
+    size_t barBytes = 0;
+    for (auto bar : m_vBars)
+        barBytes += bar->ownTextureBytes();
+    const size_t TEXTUREBYTES = textureBytes();
+    result += std::format("textures:\n\tbudget: {}MB\n\tin use: {:.1f}MB\n\tbars: {:.1f}MB\n\tshared: {:.1f}MB\n\tbar evictions: {}\n", texture_budget_mb,
+                          TEXTUREBYTES / 1048576.0, barBytes / 1048576.0, (TEXTUREBYTES - barBytes) / 1048576.0, m_iTextureEvictions);
+
+    const size_t NINEPATCHBYTES = surfaceBytes(activeSurface) + (inactiveSurface != activeSurface ? surfaceBytes(inactiveSurface) : 0);
+    result += std::format("cpu pixels:\n\tlow memory: {}\n\tnine-patches: {}KB\n\ticon mip chains: {}KB\n\ticon disk cache: {}KB\n\tresident: {}KB\n\treleased: {}KB\n\tnine-patch decodes: {}\n",
+                          low_memory, NINEPATCHBYTES / 1024, IL.m_iMipChainBytes.load() / 1024, DC.ownedBytes() / 1024, cpuPixelBytes() / 1024, m_iCpuBytesReleased / 1024,
+                          m_iNinePatchDecodes);
+
+    result += std::format("warm-up:\n\twarmed: {}\n\tdeferred: {}\n\tworkspaces visited: {}\n", m_iWarmUps, m_iWarmUpsDeferred, m_mWorkspaceVisits.size());
+
+    result += std::format("blur:\n\tcached frames: {}\n\tlive frames: {}\n", m_iCachedBlurFrames, m_iLiveBlurFrames);
+
+    result += std::format("drag:\n\tmove events: {}\n\tmoves applied: {}\n", m_pDragEngine->m_iMoveEvents, m_pDragEngine->m_iMovesApplied);
+
+    result += "windows:\n";
+    for (auto bar : m_vBars)
+    {
+        if (bar)
+            result += "\t" + bar->getStats();
+    }
+
+    return result;
+}
+
+size_t CPlugin::textureBytes() const
+{
+    size_t total = 0;
+    for (auto bar : m_vBars)
+        total += bar->ownTextureBytes();
+
+    m_titleTextures.forEach([&total](const auto &key, const auto &title)
+                            { total += ::textureBytes(title->tex); });
+    m_iconTextures.forEach([&total](const auto &key, const auto &icon)
+                           { total += ::textureBytes(icon); });
+    return total;
+}
+
+void CPlugin::enforceTextureBudget()
+{
+    if (texture_budget_mb <= 0)
+        return;
+
+    const size_t BUDGET = (size_t)texture_budget_mb * 1024 * 1024;
+    if (textureBytes() <= BUDGET)
+        return;
+
+    // nobody draws these
+    m_titleTextures.dropIdle();
+    m_iconTextures.dropIdle();
+
+    size_t total = textureBytes();
+    if (total <= BUDGET)
+        return;
+
+    auto bars = m_vBars;
+    std::ranges::sort(bars, {}, &CHyprWindowDecorator::lastDrawn);
+
+    const auto NOW = Time::steadyNow();
+    for (auto bar : bars)
+    {
+        // anything on screen would just be rasterized again next frame
+        if (total <= BUDGET || NOW - bar->lastDrawn() < TEXTURE_EVICT_MIN_UNSEEN)
+            break;
+
+        total -= std::min(total, bar->releaseTextures());
+        m_iTextureEvictions++;
+    }
+
+    // titles and icons only the released bars used
+    m_titleTextures.dropIdle();
+    m_iconTextures.dropIdle();
+}
+
+SDecodeLimits CPlugin::imageLimits() const
+{
+    return SDecodeLimits{image_max_size, (size_t)image_max_decode_mb * 1024 * 1024};
+}
+
+CHyprWindowDecorator *CPlugin::barForWindow(PHLWINDOW window)
+{
+    const auto IT = m_mBarsByWindow.find(window);
+    return IT != m_mBarsByWindow.end() ? IT->second : nullptr;
 }
 
 CPlugin::~CPlugin()
 {
+    if (m_pSurfaceReleaseTimer)
+        g_pEventLoopManager->removeTimer(m_pSurfaceReleaseTimer);
+    if (m_pWarmUpTimer)
+        g_pEventLoopManager->removeTimer(m_pWarmUpTimer);
+
+    if (activeSurface)
+        cairo_surface_destroy(activeSurface);
+    if (inactiveSurface && inactiveSurface != activeSurface)
+        cairo_surface_destroy(inactiveSurface);
+}
+
+bool CPlugin::hasNinePatch() const
+{
+    return m_bHasNinePatch;
+}
+
+cairo_surface_t *CPlugin::ninePatchSurface(bool focused)
+{
+    if (!m_bHasNinePatch)
+        return nullptr;
+
+    if (!activeSurface)
+    {
+        SNinePatchInfo npi;
+        activeSurface = loadSurface(ninepatch_active, &npi);
+        m_iNinePatchDecodes++;
+    }
+
+    if (!inactiveSurface)
+    {
+        if (m_bSharedNinePatch)
+            inactiveSurface = activeSurface;
+        else
+        {
+            SNinePatchInfo npi;
+            inactiveSurface = loadSurface(ninepatch_inactive, &npi);
+            m_iNinePatchDecodes++;
+        }
+    }
+
+    if (low_memory)
+        m_pSurfaceReleaseTimer->updateTimeout(LOW_MEMORY_RELEASE_DELAY);
+
+    return focused ? activeSurface : inactiveSurface;
+}
+
+void CPlugin::releaseNinePatchSurfaces()
+{
+    if (!low_memory)
+        return;
+
+    m_iCpuBytesReleased += surfaceBytes(activeSurface) + (inactiveSurface != activeSurface ? surfaceBytes(inactiveSurface) : 0);
+
     if (activeSurface)
         cairo_surface_destroy(activeSurface);
     if (inactiveSurface && inactiveSurface != activeSurface)
         cairo_surface_destroy(inactiveSurface);
+
+    activeSurface = nullptr;
+    inactiveSurface = nullptr;
+}
+
+void CPlugin::onWorkspaceShown(PHLWORKSPACE workspace)
+{
+    if (!workspace)
+        return;
+
+    m_mWorkspaceVisits[workspace->m_id] = ++m_iWorkspaceVisits;
+    scheduleWarmUp();
+}
+
+void CPlugin::scheduleWarmUp()
+{
+    m_iWarmUpRound++;
+    m_pWarmUpTimer->updateTimeout(WARMUP_INTERVAL);
+}
+
+void CPlugin::warmUpNext()
+{
+    if (!enabled)
+        return;
+
+    // visible bars come first, try again once they stopped rasterizing
+    if (Time::steadyNow() - m_lastVisibleRaster < WARMUP_INTERVAL)
+    {
+        m_iWarmUpsDeferred++;
+        m_pWarmUpTimer->updateTimeout(WARMUP_INTERVAL);
+        return;
+    }
+
+    // warming up more would only evict bars that are on screen
+    if (texture_budget_mb > 0 && textureBytes() >= (size_t)texture_budget_mb * 1024 * 1024 * 3 / 4)
+        return;
+
+    std::vector<std::pair<uint64_t, CHyprWindowDecorator *>> candidates;
+    for (auto bar : m_vBars)
+    {
+        if (bar->m_iWarmUpRound == m_iWarmUpRound)
+            continue;
+
+        const auto PWINDOW = bar->getOwner();
+        if (!PWINDOW || PWINDOW->m_pinned || !PWINDOW->m_workspace || PWINDOW->m_workspace->isVisible())
+            continue;
+
+        const auto VISIT = m_mWorkspaceVisits.find(PWINDOW->m_workspace->m_id);
+        candidates.emplace_back(VISIT != m_mWorkspaceVisits.end() ? VISIT->second : 0, bar);
+    }
+
+    // most recently visited workspace first, it is the likeliest to come back
+    std::ranges::stable_sort(candidates, std::greater{}, &std::pair<uint64_t, CHyprWindowDecorator *>::first);
+
+    g_pHyprRenderer->makeEGLCurrent();
+
+    // bars that are already up to date cost nothing, keep going until one actually rasterized
+    for (const auto &[_, bar] : candidates)
+    {
+        bar->m_iWarmUpRound = m_iWarmUpRound;
+        if (!bar->warmUp())
+            continue;
+
+        m_iWarmUps++;
+        enforceTextureBudget();
+        m_pWarmUpTimer->updateTimeout(WARMUP_INTERVAL);
+        return;
+    }
+}
+
+size_t CPlugin::cpuPixelBytes() const
+{
+    size_t total = surfaceBytes(activeSurface) + (inactiveSurface != activeSurface ? surfaceBytes(inactiveSurface) : 0);
+    total += m_pIconLoader->m_iMipChainBytes + m_pIconLoader->diskCache().ownedBytes();
+    return total;
 }
 
 void CPlugin::update()
@@ -163,6 +459,9 @@ void CPlugin::update()
     auto *const PPADDING = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:decoration_padding")->getDataStaticPtr();
     auto *const PBUTPADDING = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:bar_button_padding")->getDataStaticPtr();
     auto *const PONDOUBLECLICK = (Hyprlang::STRING const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:on_double_click")->getDataStaticPtr();
+    auto *const PTITLEINTERVAL = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:title_update_interval")->getDataStaticPtr();
+    auto *const PTITLEINTERVALUNFOCUSED = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:title_update_interval_unfocused")->getDataStaticPtr();
+    auto *const PRESIZESETTLE = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:resize_settle_ms")->getDataStaticPtr();
 
     auto *const PTEXTURE = (Hyprlang::STRING const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:ninepatch_texture")->getDataStaticPtr();
     auto *const PTEXACTIVE = (Hyprlang::STRING const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:ninepatch_active")->getDataStaticPtr();
@@ -177,6 +476,11 @@ void CPlugin::update()
     auto *const PSHOWAPPICON = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:decoration_appicon_enabled")->getDataStaticPtr();
     auto *const PBARABOVE = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:decoration_render_above")->getDataStaticPtr();
     auto *const PAPPICONOFFSET = (Hyprlang::VEC2 *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:decoration_appicon_offset")->getDataStaticPtr();
+    auto *const PICONTHEME = (Hyprlang::STRING const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:icon_theme")->getDataStaticPtr();
+    auto *const PIMAGEMAXSIZE = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:image_max_size")->getDataStaticPtr();
+    auto *const PIMAGEMAXMB = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:image_max_decode_mb")->getDataStaticPtr();
+    auto *const PTEXTUREBUDGET = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:texture_budget_mb")->getDataStaticPtr();
+    auto *const PLOWMEMORY = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(m_pHandle, "plugin:hyprdecor:low_memory")->getDataStaticPtr();
 
     bar_color = CHyprColor(**PBARCOLOR);
     decoration_offset_top = **PHEIGHT;
@@ -184,16 +488,29 @@ void CPlugin::update()
     decoration_title_size = **PTEXTSIZE;
     decoration_title_enabled = **PTITLEENABLED;
     bar_blur = **PBARBLUR;
+    if (bar_text_font != *PTEXTFONT)
+        m_titleLayouts.clear();
     bar_text_font = *PTEXTFONT;
     decoration_title_align = **PTEXTALIGN;
-    decoration_title_placement = *PTEXTPLACE;
+    decoration_title_placement = titlePlacementFromString(*PTEXTPLACE);
     bar_part_of_window = **PPARTOW;
     bar_precedence_over_border = **PPRECEDENCE;
-    bar_buttons_alignment = *PALIGNBUTTONS;
+    bar_buttons_alignment = buttonsAlignmentFromString(*PALIGNBUTTONS);
     decoration_padding = **PPADDING;
     bar_button_padding = **PBUTPADDING;
     enabled = **PENABLED;
     on_double_click = *PONDOUBLECLICK;
+    on_double_click_action = parseButtonAction(on_double_click);
+    title_update_interval = std::max<Hyprlang::INT>(0, **PTITLEINTERVAL);
+    title_update_interval_unfocused = std::max<Hyprlang::INT>(0, **PTITLEINTERVALUNFOCUSED);
+    resize_settle_ms = std::max<Hyprlang::INT>(0, **PRESIZESETTLE);
+
+    // before anything below loads images
+    image_max_size = std::max<Hyprlang::INT>(16, **PIMAGEMAXSIZE);
+    image_max_decode_mb = std::max<Hyprlang::INT>(1, **PIMAGEMAXMB);
+    m_pIconLoader->setLimits(imageLimits());
+    low_memory = **PLOWMEMORY;
+    m_pIconLoader->setLowMemory(low_memory);
 
     const auto PTEXTURE_STR = PTEXTURE ? *PTEXTURE : nullptr;
     const auto PTEXACT = PTEXACTIVE ? *PTEXACTIVE : nullptr;
@@ -231,6 +548,11 @@ void CPlugin::update()
     inactiveSurface = newInactiveSurface ? newInactiveSurface : newActiveSurface;
     activeNinepatch = newActiveNPI;
     inactiveNinepatch = newInactiveSurface ? newInactiveNPI : newActiveNPI;
+    m_bHasNinePatch = newActiveSurface;
+    m_bSharedNinePatch = !newInactiveSurface;
+
+    if (low_memory)
+        m_pSurfaceReleaseTimer->updateTimeout(LOW_MEMORY_RELEASE_DELAY);
 
     ninepatch_middle_alpha = **PMIDDLEALPHA;
     decoration_inset = **PINSET;
@@ -242,6 +564,12 @@ void CPlugin::update()
     decoration_appicon_enabled = **PSHOWAPPICON;
     decoration_render_above = **PBARABOVE;
     decoration_appicon_offset = {(*PAPPICONOFFSET)->x, (*PAPPICONOFFSET)->y};
+    texture_budget_mb = std::max<Hyprlang::INT>(0, **PTEXTUREBUDGET);
+    icon_theme = *PICONTHEME;
+    m_iconThemes.setTheme(icon_theme);
+    m_pIconLoader->setTheme(icon_theme);
+
+    m_iLayoutGeneration++;
 
     // Damage and update windows after all bars are invalidated
     for (auto bar : m_vBars)
@@ -261,4 +589,7 @@ void CPlugin::update()
     }
 
     loadAllTextures();
+
+    // hidden bars were just invalidated as well
+    scheduleWarmUp();
 }
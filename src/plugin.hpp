@@ -3,11 +3,22 @@
 #include <hyprlang.hpp>
 #include <hyprland/src/plugins/PluginAPI.hpp>
 #include <hyprland/src/render/Texture.hpp>
+#include <hyprland/src/managers/eventLoop/EventLoopTimer.hpp>
 #include <cairo/cairo.h>
+#include "textCache.hpp"
+#include "inputRouter.hpp"
+#include "layout.hpp"
+#include "dragEngine.hpp"
+#include "actions.hpp"
+#include "desktopIndex.hpp"
+#include "iconThemeIndex.hpp"
+#include "iconCache.hpp"
+#include "iconLoader.hpp"
 
 struct SHyprButton
 {
     std::string cmd = "";
+    SButtonAction action;
     Vector2D size = {10, 10};
 
     // textured states
@@ -24,6 +35,11 @@ struct SHyprButton
 
 class CHyprWindowDecorator;
 
+inline size_t textureBytes(const SP<CTexture> &tex)
+{
+    return tex && tex->m_texID ? (size_t)tex->m_size.x * (size_t)tex->m_size.y * 4 : 0;
+}
+
 struct SNinePatchInfo
 {
     float border[4] = {0, 0, 0, 0};  // L, T, R, B
@@ -39,6 +55,23 @@ public:
 
     void update();
     void loadAllTextures();
+    std::string getStats();
+    CHyprWindowDecorator *barForWindow(PHLWINDOW window);
+    SDecodeLimits imageLimits() const;
+    // all textures of all bars, shared ones counted once
+    size_t textureBytes() const;
+    // evicts least recently drawn textures until under texture_budget_mb, idle shared ones first
+    void enforceTextureBudget();
+    // nine-patch pixels for rasterizing a bar, decoded again if low_memory released them
+    cairo_surface_t *ninePatchSurface(bool focused);
+    bool hasNinePatch() const;
+    void releaseNinePatchSurfaces();
+    // nine-patch surfaces, icon mip chains and pixels the disk cache holds in memory
+    size_t cpuPixelBytes() const;
+    // remembers the order workspaces were visited in, hidden ones are warmed up most recent first
+    void onWorkspaceShown(PHLWORKSPACE workspace);
+    // starts warming up every bar on a hidden workspace again
+    void scheduleWarmUp();
 
     CHyprColor bar_color;
     int decoration_offset_top;
@@ -48,14 +81,18 @@ public:
     bool bar_blur;
     std::string bar_text_font;
     float decoration_title_align;
-    std::string decoration_title_placement;
+    eTitlePlacement decoration_title_placement;
     bool bar_part_of_window;
     bool bar_precedence_over_border;
-    std::string bar_buttons_alignment;
+    eButtonsAlignment bar_buttons_alignment;
     int decoration_padding;
     int bar_button_padding;
     bool enabled;
     std::string on_double_click;
+    SButtonAction on_double_click_action;
+    int title_update_interval;
+    int title_update_interval_unfocused;
+    int resize_settle_ms;
 
     std::string ninepatch_texture;
     std::string ninepatch_active;
@@ -72,17 +109,66 @@ public:
     bool decoration_appicon_enabled;
     bool decoration_render_above;
     Vector2D decoration_appicon_offset;
+    std::string icon_theme;
+    int image_max_size = 1024;
+    int image_max_decode_mb = 64;
+    int texture_budget_mb = 256;
+    bool low_memory = false;
 
-    // Parsed results
+    // Parsed results, with low_memory these are released a moment after use, see ninePatchSurface()
     cairo_surface_t *activeSurface = nullptr;
     cairo_surface_t *inactiveSurface = nullptr;
+    // the active nine-patch loaded, the inactive one is the active one
+    bool m_bHasNinePatch = false;
+    bool m_bSharedNinePatch = true;
 
     HANDLE m_pHandle = nullptr;
     std::vector<SHyprButton> m_vButtons;
     std::vector<CHyprWindowDecorator *> m_vBars;
+    // weak refs keep their identity after the window is gone, so bars can always erase themselves
+    std::unordered_map<PHLWINDOWREF, CHyprWindowDecorator *> m_mBarsByWindow;
     uint32_t m_nobarRuleIdx = 0;
     uint32_t m_barColorRuleIdx = 0;
     uint32_t m_titleColorRuleIdx = 0;
+
+    CTitleLayoutCache m_titleLayouts;
+    CTitleTextureCache m_titleTextures{TITLE_TEXTURE_CACHE_IDLE};
+    CDesktopFileIndex m_desktopIndex;
+    CIconThemeIndex m_iconThemes;
+    CIconTextureCache m_iconTextures{ICON_TEXTURE_CACHE_IDLE};
+    // declared after what it uses, its worker is stopped before they go away
+    std::unique_ptr<CIconLoader> m_pIconLoader;
+    std::unique_ptr<CInputRouter> m_pInputRouter;
+    std::unique_ptr<CDragEngine> m_pDragEngine;
+
+    // images over the size limits, icons are counted by the icon loader
+    size_t m_iImagesReduced = 0;
+    size_t m_iImagesRejected = 0;
+
+    size_t m_iTextureEvictions = 0;
+
+    SP<CEventLoopTimer> m_pSurfaceReleaseTimer;
+    size_t m_iNinePatchDecodes = 0;
+    size_t m_iCpuBytesReleased = 0;
+
+    // bars on hidden workspaces get their textures a few at a time while nothing else rasterizes
+    SP<CEventLoopTimer> m_pWarmUpTimer;
+    uint64_t m_iWarmUpRound = 0;
+    Time::steady_tp m_lastVisibleRaster;
+    std::unordered_map<WORKSPACEID, uint64_t> m_mWorkspaceVisits;
+    uint64_t m_iWorkspaceVisits = 0;
+    size_t m_iWarmUps = 0;
+    size_t m_iWarmUpsDeferred = 0;
+
+    // bar backgrounds drawn over Hyprland's precomputed blur or blurred live
+    size_t m_iCachedBlurFrames = 0;
+    size_t m_iLiveBlurFrames = 0;
+
+    // bumped whenever something decoration layouts depend on changes
+    uint64_t m_iLayoutGeneration = 1;
+
+private:
+    void warmUpNext();
 };
 
 inline std::unique_ptr<CPlugin> gPlugin;
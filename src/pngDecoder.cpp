@@ -0,0 +1,171 @@
+#include "pngDecoder.hpp"
+
+#include <hyprland/src/debug/log/Logger.hpp>
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <png.h>
+
+static void premultiplyRow(uint8_t *row, int width)
+{
+    // BGRA bytes, which is ARGB32 on little endian
+    for (int x = 0; x < width; ++x)
+    {
+        uint8_t *px = row + x * 4;
+        const uint32_t A = px[3];
+        if (A == 255)
+            continue;
+
+        for (int c = 0; c < 3; ++c)
+            px[c] = (px[c] * A + 127) / 255;
+    }
+}
+
+// libpng prints to stderr by default, a broken icon is not worth more than a trace line
+static void onPngError(png_structp png, png_const_charp message)
+{
+    Log::logger->log(Log::TRACE, "[HYPRDECOR] Failed to decode {}: {}", (const char *)png_get_error_ptr(png), message);
+    png_longjmp(png, 1);
+}
+
+static void onPngWarning(png_structp png, png_const_charp message)
+{
+    Log::logger->log(Log::TRACE, "[HYPRDECOR] {}: {}", (const char *)png_get_error_ptr(png), message);
+}
+
+eDecodeResult decodePng(const std::string &path, const SDecodeLimits &limits, bool allowReduce, SImage &out)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return DECODE_FAILED;
+
+    png_byte signature[8];
+    if (fread(signature, 1, sizeof(signature), file) != sizeof(signature) || png_sig_cmp(signature, 0, sizeof(signature)) != 0)
+    {
+        fclose(file);
+        return DECODE_FAILED;
+    }
+
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)path.c_str(), onPngError, onPngWarning);
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    if (!info)
+    {
+        png_destroy_read_struct(&png, nullptr, nullptr);
+        fclose(file);
+        return DECODE_FAILED;
+    }
+
+    // everything with a destructor lives outside the setjmp scope
+    std::vector<uint8_t> rows;
+    std::vector<uint64_t> sums;
+    SImage image;
+
+    if (setjmp(png_jmpbuf(png)))
+    {
+        png_destroy_read_struct(&png, &info, nullptr);
+        fclose(file);
+        return DECODE_FAILED;
+    }
+
+    png_init_io(png, file);
+    png_set_sig_bytes(png, sizeof(signature));
+    png_read_info(png, info);
+
+    const int WIDTH = png_get_image_width(png, info);
+    const int HEIGHT = png_get_image_height(png, info);
+    const bool INTERLACED = png_get_interlace_type(png, info) != PNG_INTERLACE_NONE;
+
+    // how many source pixels per side go into one output pixel
+    int factor = 1;
+    if (limits.maxSize > 0 && std::max(WIDTH, HEIGHT) > limits.maxSize)
+        factor = (std::max(WIDTH, HEIGHT) + limits.maxSize - 1) / limits.maxSize;
+
+    const bool TOOLARGE = limits.maxBytes && (size_t)WIDTH * HEIGHT * 4 > limits.maxBytes;
+    if (TOOLARGE || (factor > 1 && !allowReduce))
+    {
+        png_destroy_read_struct(&png, &info, nullptr);
+        fclose(file);
+        return DECODE_TOO_LARGE;
+    }
+
+    // whatever it is, make it 8 bit BGRA
+    png_set_expand(png);
+    png_set_strip_16(png);
+    png_set_gray_to_rgb(png);
+    png_set_add_alpha(png, 0xff, PNG_FILLER_AFTER);
+    png_set_bgr(png);
+    const int PASSES = png_set_interlace_handling(png);
+    png_read_update_info(png, info);
+
+    const size_t ROWBYTES = (size_t)WIDTH * 4;
+
+    // interlaced images need the full image before any row is final, maxBytes bounds that too
+    if (INTERLACED)
+    {
+        rows.resize(ROWBYTES * HEIGHT);
+        for (int pass = 0; pass < PASSES; ++pass)
+        {
+            for (int y = 0; y < HEIGHT; ++y)
+                png_read_row(png, rows.data() + y * ROWBYTES, nullptr);
+        }
+    }
+    else
+        rows.resize(ROWBYTES);
+
+    image.width = (WIDTH + factor - 1) / factor;
+    image.height = (HEIGHT + factor - 1) / factor;
+    image.pixels.resize((size_t)image.width * image.height);
+
+    if (factor > 1)
+        sums.resize((size_t)image.width * 4);
+
+    for (int y = 0; y < HEIGHT; ++y)
+    {
+        uint8_t *row = rows.data() + (INTERLACED ? y * ROWBYTES : 0);
+        if (!INTERLACED)
+            png_read_row(png, row, nullptr);
+
+        premultiplyRow(row, WIDTH);
+
+        if (factor == 1)
+        {
+            std::memcpy(&image.pixels[(size_t)y * WIDTH], row, ROWBYTES);
+            continue;
+        }
+
+        for (int x = 0; x < WIDTH; ++x)
+        {
+            for (int c = 0; c < 4; ++c)
+                sums[(x / factor) * 4 + c] += row[x * 4 + c];
+        }
+
+        // an output row is done, edge rows and columns average fewer pixels
+        if ((y + 1) % factor == 0 || y == HEIGHT - 1)
+        {
+            const int OUTY = y / factor;
+            const int ROWSIN = y - OUTY * factor + 1;
+
+            for (int x = 0; x < image.width; ++x)
+            {
+                const int COLSIN = std::min(factor, WIDTH - x * factor);
+                const uint64_t COUNT = ROWSIN * COLSIN;
+
+                uint32_t px = 0;
+                for (int c = 0; c < 4; ++c)
+                    px |= (uint32_t)((sums[x * 4 + c] + COUNT / 2) / COUNT) << (c * 8);
+                image.pixels[(size_t)OUTY * image.width + x] = px;
+            }
+
+            std::ranges::fill(sums, 0);
+        }
+    }
+
+    png_read_end(png, nullptr);
+    png_destroy_read_struct(&png, &info, nullptr);
+    fclose(file);
+
+    out = std::move(image);
+    return factor > 1 ? DECODE_REDUCED : DECODE_OK;
+}
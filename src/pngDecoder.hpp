@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "imageScale.hpp"
+
+struct SDecodeLimits
+{
+    // largest side of the decoded result, 0 for no limit
+    int maxSize = 0;
+    // largest source, width * height * 4, that is decoded at all. 0 for no limit
+    size_t maxBytes = 0;
+};
+
+enum eDecodeResult : uint8_t
+{
+    DECODE_OK = 0,
+    // larger than maxSize, reduced while decoding
+    DECODE_REDUCED,
+    // over maxBytes, or over maxSize and not reducible
+    DECODE_TOO_LARGE,
+    DECODE_FAILED,
+};
+
+// Decodes a png row by row into premultiplied ARGB32. Sources past maxSize are
+// box filtered down while decoding so the full size image never exists in memory.
+// Nine-patches pass allowReduce = false, their 1px markers can't be scaled.
+eDecodeResult decodePng(const std::string &path, const SDecodeLimits &limits, bool allowReduce, SImage &out);
@@ -15,15 +15,7 @@ void CRenderPassElement::draw(const CRegion &damage)
 
 bool CRenderPassElement::needsLiveBlur()
 {
-    static auto *const PENABLEBLURGLOBAL = (Hyprlang::INT *const *)HyprlandAPI::getConfigValue(gPlugin->m_pHandle, "decoration:blur:enabled")->getDataStaticPtr();
-    if (!**PENABLEBLURGLOBAL)
-        return false;
-
-    CHyprColor color = data.deco->m_bForcedBarColor.value_or(gPlugin->bar_color);
-    color.a *= data.a;
-    const bool SHOULDBLUR = gPlugin->bar_blur && gPlugin->bar_blur && color.a < 1.F;
-
-    return SHOULDBLUR;
+    return data.deco->m_bBlur && !data.deco->m_bCachedBlur;
 }
 
 std::optional<CBox> CRenderPassElement::boundingBox()
@@ -34,5 +26,5 @@ std::optional<CBox> CRenderPassElement::boundingBox()
 
 bool CRenderPassElement::needsPrecomputeBlur()
 {
-    return false;
+    return data.deco->m_bBlur && data.deco->m_bCachedBlur;
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <hyprland/src/helpers/memory/Memory.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Hands out shared values by key. Entries stay alive as long as anyone holds them,
+// once only the cache references an entry it is idle and the least recently used
+// idle entries past maxIdle are dropped.
+template <typename K, typename V, typename H = std::hash<K>>
+class CSharedCache
+{
+public:
+    explicit CSharedCache(size_t maxIdle) : m_iMaxIdle(maxIdle)
+    {
+        ;
+    }
+
+    SP<V> get(const K &key)
+    {
+        auto it = m_mEntries.find(key);
+        if (it == m_mEntries.end())
+        {
+            m_iMisses++;
+            return nullptr;
+        }
+
+        m_iHits++;
+        it->second.lastUsed = ++m_iTick;
+        return it->second.value;
+    }
+
+    SP<V> insert(const K &key, SP<V> value)
+    {
+        m_mEntries[key] = SEntry{value, ++m_iTick};
+        trim();
+        return value;
+    }
+
+    void trim()
+    {
+        std::vector<typename decltype(m_mEntries)::iterator> idle;
+        for (auto it = m_mEntries.begin(); it != m_mEntries.end(); ++it)
+        {
+            if (it->second.value.strongRef() <= 1)
+                idle.push_back(it);
+        }
+
+        if (idle.size() <= m_iMaxIdle)
+            return;
+
+        std::sort(idle.begin(), idle.end(), [](const auto &a, const auto &b)
+                  { return a->second.lastUsed < b->second.lastUsed; });
+
+        for (size_t i = 0; i < idle.size() - m_iMaxIdle; ++i)
+        {
+            m_mEntries.erase(idle[i]);
+            m_iEvictions++;
+        }
+    }
+
+    // drops every idle entry regardless of maxIdle, returns how many
+    size_t dropIdle()
+    {
+        const size_t DROPPED = std::erase_if(m_mEntries, [](const auto &e)
+                                             { return e.second.value.strongRef() <= 1; });
+        m_iEvictions += DROPPED;
+        return DROPPED;
+    }
+
+    void clear()
+    {
+        m_mEntries.clear();
+    }
+
+    template <typename F>
+    void forEach(F &&fn) const
+    {
+        for (const auto &[key, entry] : m_mEntries)
+            fn(key, entry.value);
+    }
+
+    size_t size() const
+    {
+        return m_mEntries.size();
+    }
+
+    size_t m_iHits = 0;
+    size_t m_iMisses = 0;
+    size_t m_iEvictions = 0;
+
+private:
+    struct SEntry
+    {
+        SP<V> value;
+        uint64_t lastUsed = 0;
+    };
+
+    std::unordered_map<K, SEntry, H> m_mEntries;
+    size_t m_iMaxIdle = 0;
+    uint64_t m_iTick = 0;
+};
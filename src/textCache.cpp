@@ -0,0 +1,129 @@
+#include "textCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+// Max number of shaped layouts kept around.
+constexpr size_t TITLE_LAYOUT_CACHE_SIZE = 256;
+
+// No glyph we care about advances less than this fraction of the font size, so
+// nothing past maxWidth / (size * fraction) codepoints can survive ellipsizing.
+constexpr float MIN_GLYPH_ADVANCE = 0.25f;
+constexpr long MIN_SHAPED_CODEPOINTS = 32;
+
+size_t STitleLayoutKeyHash::operator()(const STitleLayoutKey &k) const
+{
+    size_t h = std::hash<std::string>{}(k.text);
+    h ^= std::hash<std::string>{}(k.font) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<int>{}(k.size) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<int>{}(k.maxWidth) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+}
+
+size_t STitleTextureKeyHash::operator()(const STitleTextureKey &k) const
+{
+    size_t h = std::hash<std::string>{}(k.text);
+    h ^= std::hash<std::string>{}(k.font) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    for (const int v : {k.size, k.scale, (int)k.color, k.maxWidth})
+        h ^= std::hash<int>{}(v) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+}
+
+CTitleLayoutCache::~CTitleLayoutCache()
+{
+    clear();
+}
+
+void CTitleLayoutCache::clear()
+{
+    for (auto &e : m_lLayouts)
+        g_object_unref(e.layout);
+
+    m_lLayouts.clear();
+    m_mLayouts.clear();
+
+    for (auto &[_, f] : m_mFonts)
+    {
+        pango_font_description_free(f.fontDesc);
+        g_object_unref(f.context);
+    }
+
+    m_mFonts.clear();
+}
+
+CTitleLayoutCache::SFontState &CTitleLayoutCache::fontState(const std::string &font, int size)
+{
+    const auto KEY = std::format("{}@{}", font, size);
+
+    auto it = m_mFonts.find(KEY);
+    if (it != m_mFonts.end())
+        return it->second;
+
+    SFontState state;
+    state.context = pango_font_map_create_context(pango_cairo_font_map_get_default());
+    pango_context_set_base_dir(state.context, PANGO_DIRECTION_NEUTRAL);
+
+    // match what pango_cairo_create_layout would pick up from an image surface
+    cairo_font_options_t *options = cairo_font_options_create();
+    cairo_font_options_set_hint_metrics(options, CAIRO_HINT_METRICS_ON);
+    pango_cairo_context_set_font_options(state.context, options);
+    cairo_font_options_destroy(options);
+
+    state.fontDesc = pango_font_description_from_string(font.c_str());
+    pango_font_description_set_size(state.fontDesc, size);
+
+    return m_mFonts.emplace(KEY, state).first->second;
+}
+
+PangoLayout *CTitleLayoutCache::get(const std::string &text, const std::string &font, float pixelSize, float maxWidth)
+{
+    STitleLayoutKey key;
+    key.font = font;
+    key.size = (int)std::round(pixelSize * PANGO_SCALE);
+    key.maxWidth = (int)std::round(std::max(0.f, maxWidth) * PANGO_SCALE);
+
+    // Don't shape what ellipsizing would throw away anyway (2k character urls etc.)
+    const long MAXCODEPOINTS = std::max(MIN_SHAPED_CODEPOINTS, (long)std::ceil(maxWidth / std::max(1.f, pixelSize * MIN_GLYPH_ADVANCE)) + 1);
+    if ((long)text.size() > MAXCODEPOINTS && g_utf8_strlen(text.c_str(), text.size()) > MAXCODEPOINTS)
+    {
+        const char *end = g_utf8_offset_to_pointer(text.c_str(), MAXCODEPOINTS);
+        // keep the ellipsis even if the cut text happens to fit
+        key.text = text.substr(0, end - text.c_str()) + "…";
+        m_iTruncations++;
+    }
+    else
+        key.text = text;
+
+    auto it = m_mLayouts.find(key);
+    if (it != m_mLayouts.end())
+    {
+        m_iHits++;
+        m_lLayouts.splice(m_lLayouts.begin(), m_lLayouts, it->second);
+        return it->second->layout;
+    }
+
+    m_iMisses++;
+
+    const auto &FONT = fontState(font, key.size);
+
+    PangoLayout *layout = pango_layout_new(FONT.context);
+    pango_layout_set_text(layout, key.text.c_str(), -1);
+    pango_layout_set_font_description(layout, FONT.fontDesc);
+    pango_layout_set_width(layout, key.maxWidth);
+    pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
+
+    m_lLayouts.push_front(SLayoutEntry{key, layout});
+    m_mLayouts.emplace(std::move(key), m_lLayouts.begin());
+
+    while (m_lLayouts.size() > TITLE_LAYOUT_CACHE_SIZE)
+    {
+        auto &last = m_lLayouts.back();
+        m_mLayouts.erase(last.key);
+        g_object_unref(last.layout);
+        m_lLayouts.pop_back();
+        m_iEvictions++;
+    }
+
+    return layout;
+}
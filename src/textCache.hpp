@@ -0,0 +1,105 @@
+#pragma once
+
+#include <hyprland/src/render/Texture.hpp>
+#include <hyprland/src/helpers/math/Math.hpp>
+#include <pango/pangocairo.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "sharedCache.hpp"
+
+// ellipsized titles are laid out for widths rounded down to this many pixels
+constexpr int TITLE_WIDTH_BUCKET = 16;
+// rasterized titles no window currently uses that are kept around
+constexpr size_t TITLE_TEXTURE_CACHE_IDLE = 64;
+
+struct STitleLayoutKey
+{
+    std::string text;
+    std::string font;
+    int size = 0;     // pango units
+    int maxWidth = 0; // pango units
+
+    bool operator==(const STitleLayoutKey &) const = default;
+};
+
+struct STitleLayoutKeyHash
+{
+    size_t operator()(const STitleLayoutKey &k) const;
+};
+
+// Shapes title text once and keeps the result around. Font descriptions and
+// pango contexts live as long as the font/size pair is in use, layouts are
+// kept in an LRU keyed by (text, font, size, max width).
+class CTitleLayoutCache
+{
+public:
+    CTitleLayoutCache() = default;
+    ~CTitleLayoutCache();
+
+    CTitleLayoutCache(const CTitleLayoutCache &) = delete;
+    CTitleLayoutCache &operator=(const CTitleLayoutCache &) = delete;
+
+    // Returns an ellipsized layout owned by the cache. It stays valid until the next get() or clear().
+    PangoLayout *get(const std::string &text, const std::string &font, float pixelSize, float maxWidth);
+
+    void clear();
+
+    size_t m_iHits = 0;
+    size_t m_iMisses = 0;
+    size_t m_iEvictions = 0;
+    size_t m_iTruncations = 0;
+
+    size_t size() const
+    {
+        return m_lLayouts.size();
+    }
+
+private:
+    struct SFontState
+    {
+        PangoContext *context = nullptr;
+        PangoFontDescription *fontDesc = nullptr;
+    };
+
+    struct SLayoutEntry
+    {
+        STitleLayoutKey key;
+        PangoLayout *layout = nullptr;
+    };
+
+    SFontState &fontState(const std::string &font, int size);
+
+    // most recently used at the front
+    std::list<SLayoutEntry> m_lLayouts;
+    std::unordered_map<STitleLayoutKey, std::list<SLayoutEntry>::iterator, STitleLayoutKeyHash> m_mLayouts;
+    std::unordered_map<std::string, SFontState> m_mFonts;
+};
+
+struct STitleTextureKey
+{
+    std::string text;
+    std::string font;
+    int size = 0;       // pango units
+    int scale = 0;      // monitor scale * 1000
+    uint32_t color = 0; // rgba8
+    int maxWidth = 0;   // width bucket when ellipsized, 0 otherwise
+
+    bool operator==(const STitleTextureKey &) const = default;
+};
+
+struct STitleTextureKeyHash
+{
+    size_t operator()(const STitleTextureKey &k) const;
+};
+
+// A rasterized title, shared by every window showing the same text at the same size.
+// Always horizontal, vertical bars rotate it when drawing.
+struct STitleTexture
+{
+    SP<CTexture> tex;
+    // ink rect relative to the layout origin
+    CBox inkBox;
+};
+
+using CTitleTextureCache = CSharedCache<STitleTextureKey, STitleTexture, STitleTextureKeyHash>;
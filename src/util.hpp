@@ -15,60 +15,46 @@
 #include <fstream>
 #include <sstream>
 #include "plugin.hpp"
+#include "pngDecoder.hpp"
 
-static cairo_surface_t *loadSurface(std::string path, SNinePatchInfo *pInfo = nullptr, int targetSize = 0)
+static cairo_surface_t *loadSurface(std::string path, SNinePatchInfo *pInfo = nullptr)
 {
     if (path.empty())
         return nullptr;
 
-    // Handle PNG files
-    cairo_surface_t *rawSurface = cairo_image_surface_create_from_png(path.c_str());
-
-    if (cairo_surface_status(rawSurface) != CAIRO_STATUS_SUCCESS)
+    // nine-patches can't be reduced without losing their markers
+    SImage image;
+    const auto RESULT = decodePng(path, gPlugin->imageLimits(), !pInfo, image);
+    if (RESULT == DECODE_TOO_LARGE)
     {
-        cairo_surface_destroy(rawSurface);
+        gPlugin->m_iImagesRejected++;
+        Log::logger->log(Log::WARN, "[HYPRDECOR] Image {} is over image_max_size or image_max_decode_mb, not loading it", path);
         return nullptr;
     }
 
-    if (!pInfo && targetSize > 0)
+    if (RESULT == DECODE_REDUCED)
     {
-        int w = cairo_image_surface_get_width(rawSurface);
-        int h = cairo_image_surface_get_height(rawSurface);
-
-        cairo_surface_t *scaledSurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, targetSize, targetSize);
-        cairo_t *cr = cairo_create(scaledSurface);
-
-        double scale = (double)targetSize / std::max(w, h);
-        double sw = w * scale;
-        double sh = h * scale;
-
-        cairo_scale(cr, scale, scale);
-        cairo_set_source_surface(cr, rawSurface, (targetSize / scale - w) / 2.0, (targetSize / scale - h) / 2.0);
-        cairo_paint(cr);
-
-        cairo_destroy(cr);
-        cairo_surface_destroy(rawSurface);
-        return scaledSurface;
+        gPlugin->m_iImagesReduced++;
+        Log::logger->log(Log::WARN, "[HYPRDECOR] Image {} is over image_max_size, reduced to {}x{}", path, image.width, image.height);
     }
 
+    if (RESULT == DECODE_FAILED)
+        return nullptr;
+
     if (!pInfo)
-        return rawSurface;
+        return surfaceFromImage(image);
 
     // Parse ninepatch if pInfo is provided
-    int w = cairo_image_surface_get_width(rawSurface);
-    int h = cairo_image_surface_get_height(rawSurface);
+    const int w = image.width;
+    const int h = image.height;
 
     if (w < 3 || h < 3)
-        return rawSurface;
-
-    unsigned char *data = cairo_image_surface_get_data(rawSurface);
-    int stride = cairo_image_surface_get_stride(rawSurface);
+        return surfaceFromImage(image);
 
     auto isBlack = [&](int x, int y)
     {
-        uint32_t pixel = *(uint32_t *)(data + y * stride + x * 4);
-        // Cairo ARGB32: 0xAARRGGBB. Standard .9.png markers are opaque black.
-        return ((pixel >> 24) & 0xFF) == 255 && ((pixel >> 16) & 0xFF) == 0 && ((pixel >> 8) & 0xFF) == 0 && (pixel & 0xFF) == 0;
+        // Premultiplied ARGB32. Standard .9.png markers are opaque black.
+        return image.pixels[(size_t)y * w + x] == 0xFF000000;
     };
 
     // Extract markers
@@ -142,14 +128,8 @@ static cairo_surface_t *loadSurface(std::string path, SNinePatchInfo *pInfo = nu
 
     pInfo->defined = true;
 
-    cairo_surface_t *cropped = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w - 2, h - 2);
-    cairo_t *cr = cairo_create(cropped);
-    cairo_set_source_surface(cr, rawSurface, -1, -1);
-    cairo_paint(cr);
-    cairo_destroy(cr);
-    cairo_surface_destroy(rawSurface);
-
-    return cropped;
+    // cropped straight from the decoded pixels, no full size surface in between
+    return surfaceFromImage(image, 1, 1, w - 2, h - 2);
 }
 
 static void drawSizedSurface(cairo_t *cr, cairo_surface_t *surface, double sx, double sy, double sw, double sh, double dx, double dy, double dw, double dh)
@@ -174,12 +154,8 @@ static void drawRepeatedSurface(cairo_t *cr, cairo_surface_t *surface, double sx
     cairo_rectangle(cr, dx, dy, dw, dh);
     cairo_clip(cr);
 
-    // Create a pattern from the surface region
-    cairo_surface_t *patternSurface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, sw, sh);
-    cairo_t *patternCr = cairo_create(patternSurface);
-    cairo_set_source_surface(patternCr, surface, -sx, -sy);
-    cairo_paint(patternCr);
-    cairo_destroy(patternCr);
+    // Create a pattern from the surface region, a view into it rather than a copy
+    cairo_surface_t *patternSurface = cairo_surface_create_for_rectangle(surface, sx, sy, sw, sh);
 
     // Create repeating pattern
     cairo_pattern_t *pattern = cairo_pattern_create_for_surface(patternSurface);
@@ -195,18 +171,11 @@ static void drawRepeatedSurface(cairo_t *cr, cairo_surface_t *surface, double sx
     cairo_restore(cr);
 }
 
-static void loadTexture(std::string path, SP<CTexture> &out, bool linear = true, int targetSize = 0)
+static void uploadSurface(cairo_surface_t *surface, SP<CTexture> &out, bool linear = true)
 {
-    if (path.empty() || out->m_texID != 0)
-        return;
-
-    const auto CAIROSURFACE = loadSurface(path, nullptr, targetSize);
-    if (!CAIROSURFACE)
-        return;
-
-    const auto DATA = cairo_image_surface_get_data(CAIROSURFACE);
-    const auto WIDTH = cairo_image_surface_get_width(CAIROSURFACE);
-    const auto HEIGHT = cairo_image_surface_get_height(CAIROSURFACE);
+    const auto DATA = cairo_image_surface_get_data(surface);
+    const auto WIDTH = cairo_image_surface_get_width(surface);
+    const auto HEIGHT = cairo_image_surface_get_height(surface);
 
     out->allocate();
     glBindTexture(GL_TEXTURE_2D, out->m_texID);
@@ -221,182 +190,18 @@ static void loadTexture(std::string path, SP<CTexture> &out, bool linear = true,
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, WIDTH, HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, DATA);
 
     out->m_size = {(double)WIDTH, (double)HEIGHT};
-
-    cairo_surface_destroy(CAIROSURFACE);
-}
-
-static std::string findDesktopFile(const std::string &appId)
-{
-    std::vector<std::string> searchPaths;
-
-    // Use XDG_DATA_HOME (defaults to ~/.local/share)
-    const char *xdgDataHome = getenv("XDG_DATA_HOME");
-    if (xdgDataHome && xdgDataHome[0] != '\0')
-    {
-        searchPaths.push_back(std::string(xdgDataHome) + "/applications/");
-    }
-    else
-    {
-        const char *home = getenv("HOME");
-        if (home)
-            searchPaths.push_back(std::string(home) + "/.local/share/applications/");
-    }
-
-    // Use XDG_DATA_DIRS (defaults to /usr/local/share:/usr/share)
-    const char *xdgDataDirs = getenv("XDG_DATA_DIRS");
-    std::string dataDirs = xdgDataDirs ? xdgDataDirs : "/usr/local/share:/usr/share";
-
-    std::stringstream ss(dataDirs);
-    std::string dir;
-    while (std::getline(ss, dir, ':'))
-    {
-        if (!dir.empty())
-            searchPaths.push_back(dir + "/applications/");
-    }
-
-    // Also add Flatpak paths
-    const char *home = getenv("HOME");
-    if (home)
-    {
-        searchPaths.push_back(std::string(home) + "/.local/share/flatpak/exports/share/applications/");
-    }
-    searchPaths.push_back("/var/lib/flatpak/exports/share/applications/");
-
-    // Search for desktop file
-    for (const auto &path : searchPaths)
-    {
-        if (!std::filesystem::exists(path))
-            continue;
-
-        std::string desktop = path + appId + ".desktop";
-        if (std::filesystem::exists(desktop))
-            return desktop;
-    }
-
-    return "";
-}
-
-static std::string getIconFromDesktop(const std::string &desktopPath)
-{
-    std::ifstream file(desktopPath);
-    if (!file.is_open())
-        return "";
-
-    std::string line;
-    bool inDesktopEntry = false;
-
-    while (std::getline(file, line))
-    {
-        // Check if we're in the [Desktop Entry] section
-        if (line == "[Desktop Entry]")
-            inDesktopEntry = true;
-        else if (!line.empty() && line[0] == '[')
-            inDesktopEntry = false;
-
-        if (inDesktopEntry && line.find("Icon=") == 0)
-        {
-            return line.substr(5);
-        }
-    }
-    return "";
-}
-
-static std::string resolveIconPath(const std::string &iconName)
-{
-    if (iconName.empty())
-        return "";
-
-    // If already an absolute path
-    if (iconName[0] == '/' && std::filesystem::exists(iconName))
-        return iconName;
-
-    std::vector<std::string> iconPaths;
-    const char *home = getenv("HOME");
-
-    // Common icon sizes to search (in order of preference)
-    std::vector<std::string> sizes = {"48x48", "64x64", "128x128", "scalable"};
-
-    // Common icon themes (hicolor is the fallback theme per freedesktop spec)
-    std::vector<std::string> themes = {"hicolor", "breeze", "oxygen", "Adwaita", "Papirus"};
-
-    // Get XDG data directories for icons
-    std::vector<std::string> dataDirs;
-
-    // XDG_DATA_HOME
-    const char *xdgDataHome = getenv("XDG_DATA_HOME");
-    if (xdgDataHome && xdgDataHome[0] != '\0')
-    {
-        dataDirs.push_back(std::string(xdgDataHome));
-    }
-    else if (home)
-    {
-        dataDirs.push_back(std::string(home) + "/.local/share");
-    }
-
-    // XDG_DATA_DIRS
-    const char *xdgDataDirs = getenv("XDG_DATA_DIRS");
-    std::string dataDir = xdgDataDirs ? xdgDataDirs : "/usr/local/share:/usr/share";
-
-    std::stringstream ss(dataDir);
-    std::string dir;
-    while (std::getline(ss, dir, ':'))
-    {
-        if (!dir.empty())
-        {
-            dataDirs.push_back(dir);
-        }
-    }
-
-    // Search in icon themes
-    for (const auto &baseDir : dataDirs)
-    {
-        for (const auto &theme : themes)
-        {
-            for (const auto &size : sizes)
-            {
-                // Standard structure: icons/{theme}/{size}/apps/{icon}
-                iconPaths.push_back(baseDir + "/icons/" + theme + "/" + size + "/apps/" + iconName + ".png");
-                // Oxygen structure: icons/{theme}/base/{size}/apps/{icon}
-                iconPaths.push_back(baseDir + "/icons/" + theme + "/base/" + size + "/apps/" + iconName + ".png");
-                // Breeze structure: icons/{theme}/apps/{size}/{icon} (size without 'x')
-                std::string sizeNum = size;
-                if (size.find("x") != std::string::npos)
-                    sizeNum = size.substr(0, size.find("x")); // "48x48" -> "48"
-                iconPaths.push_back(baseDir + "/icons/" + theme + "/apps/" + sizeNum + "/" + iconName + ".png");
-            }
-        }
-        // Also check pixmaps as fallback
-        iconPaths.push_back(baseDir + "/pixmaps/" + iconName + ".png");
-        iconPaths.push_back(baseDir + "/pixmaps/" + iconName);
-    }
-
-    for (const auto &path : iconPaths)
-    {
-        if (std::filesystem::exists(path) && path.ends_with(".png"))
-        {
-            return path;
-        }
-    }
-
-    return "";
 }
 
-static void loadAppIcon(const std::string &appId, SP<CTexture> &out, int targetSize)
+static void loadTexture(std::string path, SP<CTexture> &out, bool linear = true)
 {
-    if (appId.empty())
-        return;
-
-    auto desktopFile = findDesktopFile(appId);
-    if (desktopFile.empty())
+    if (path.empty() || out->m_texID != 0)
         return;
 
-    auto iconName = getIconFromDesktop(desktopFile);
-    if (iconName.empty())
+    const auto CAIROSURFACE = loadSurface(path);
+    if (!CAIROSURFACE)
         return;
 
-    auto iconPath = resolveIconPath(iconName);
-    if (iconPath.empty() || !iconPath.ends_with(".png"))
-        return;
+    uploadSurface(CAIROSURFACE, out, linear);
 
-    loadTexture(iconPath, out, true, targetSize);
+    cairo_surface_destroy(CAIROSURFACE);
 }